@@ -1,43 +1,102 @@
 #include "vpxencoder.h"
 #include "../../src/core/common.h"
 #include <vpx/vp8cx.h>
+#include <algorithm>
+#include <thread>
 
 namespace Epyx
 {
     namespace webm
     {
 
+        VpxEncoderConfig::VpxEncoderConfig(unsigned int width, unsigned int height)
+        :width(width), height(height), end_usage(VPX_CBR), buffer_ms(1000),
+        kf_mode(VPX_KF_DISABLED), kf_max_dist(999999) {
+            const unsigned int pixels = width * height;
+            const unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+
+            // Roughly one thread per 640x360 area, leaving a core to the rest
+            unsigned int wanted = std::max(1u, pixels / (640 * 360));
+            threads = std::max(1u, std::min(wanted, cores > 1 ? cores - 1 : 1));
+
+            token_partitions = 0;
+            while (token_partitions < 3 && (1u << (token_partitions + 1)) <= threads)
+                token_partitions++;
+
+            // Trade quality for speed on large frames
+            if (pixels >= 1280 * 720)
+                cpu_used = -8;
+            else if (pixels >= 640 * 480)
+                cpu_used = -6;
+            else
+                cpu_used = -4;
+
+            // About 0.1 bit per pixel at 30 frames per second
+            bitrate = std::max(100u, pixels * 3 / 1000);
+        }
+
         VpxEncoder::VpxEncoder(unsigned int display_width, unsigned int display_height,
             unsigned int video_bitrate)
         :display_width(display_width), display_height(display_height),
         video_bitrate(video_bitrate) {
-            int cpu_used = -6;
+            VpxEncoderConfig config(display_width, display_height);
+            config.bitrate = video_bitrate;
+            config.threads = 1;
+            config.token_partitions = 0;
+            config.cpu_used = -6;
+            init(config);
+        }
+
+        VpxEncoder::VpxEncoder(const VpxEncoderConfig& config)
+        :display_width(config.width), display_height(config.height),
+        video_bitrate(config.bitrate) {
+            init(config);
+        }
+
+        void VpxEncoder::init(const VpxEncoderConfig& config) {
             int static_threshold = 1200;
-            vpx_codec_enc_cfg_t cfg;
 
             vpx_codec_enc_config_default(&vpx_codec_vp8_cx_algo, &cfg, 0);
-            cfg.rc_target_bitrate = video_bitrate;
-            cfg.g_w = display_width;
-            cfg.g_h = display_height;
+            cfg.rc_target_bitrate = config.bitrate;
+            cfg.g_w = config.width;
+            cfg.g_h = config.height;
             cfg.g_timebase.num = 1;
             cfg.g_timebase.den = (int) 10000000;
-            cfg.rc_end_usage = VPX_CBR;
+            cfg.rc_end_usage = config.end_usage;
             cfg.g_pass = VPX_RC_ONE_PASS;
             cfg.g_lag_in_frames = 0;
             cfg.rc_min_quantizer = 20;
             cfg.rc_max_quantizer = 50;
             cfg.rc_dropframe_thresh = 1;
-            cfg.rc_buf_optimal_sz = 1000;
-            cfg.rc_buf_initial_sz = 1000;
-            cfg.rc_buf_sz = 1000;
+            cfg.rc_buf_optimal_sz = config.buffer_ms;
+            cfg.rc_buf_initial_sz = config.buffer_ms;
+            cfg.rc_buf_sz = config.buffer_ms;
             cfg.g_error_resilient = 1;
-            cfg.kf_mode = VPX_KF_DISABLED;
-            cfg.kf_max_dist = 999999;
-            cfg.g_threads = 1;
+            cfg.kf_mode = config.kf_mode;
+            cfg.kf_max_dist = config.kf_max_dist;
+            cfg.g_threads = config.threads;
             vpx_codec_enc_init(&encoder, &vpx_codec_vp8_cx_algo, &cfg, 0);
-            vpx_codec_control_(&encoder, VP8E_SET_CPUUSED, cpu_used);
+            vpx_codec_control_(&encoder, VP8E_SET_CPUUSED, config.cpu_used);
             vpx_codec_control_(&encoder, VP8E_SET_STATIC_THRESHOLD, static_threshold);
             vpx_codec_control_(&encoder, VP8E_SET_ENABLEAUTOALTREF, 0);
+            vpx_codec_control_(&encoder, VP8E_SET_TOKEN_PARTITIONS,
+                (int) config.token_partitions);
+        }
+
+        bool VpxEncoder::reconfigure(unsigned int bitrate, unsigned int width,
+            unsigned int height) {
+            cfg.rc_target_bitrate = bitrate;
+            cfg.g_w = width;
+            cfg.g_h = height;
+            if (vpx_codec_enc_config_set(&encoder, &cfg)) {
+                log::error << "[VPX encoder] Failed to reconfigure: "
+                    << vpx_codec_error(&encoder) << log::endl;
+                return false;
+            }
+            video_bitrate = bitrate;
+            display_width = width;
+            display_height = height;
+            return true;
         }
 
         VpxEncoder::~VpxEncoder() {
@@ -14,6 +14,68 @@ namespace Epyx
 {
     namespace webm
     {
+        /**
+         * @brief Tuning of a VpxEncoder
+         */
+        struct VpxEncoderConfig
+        {
+            /**
+             * @brief Build the defaults for a video size
+             * @param width
+             * @param height
+             *
+             * Threads and token partitions grow with the resolution, up to
+             * the number of cores, and so does the speed/quality tradeoff,
+             * so that a frame is encoded within one frame interval.
+             */
+            VpxEncoderConfig(unsigned int width, unsigned int height);
+
+            unsigned int width;
+            unsigned int height;
+
+            /**
+             * @brief Target bitrate in kbit/s
+             */
+            unsigned int bitrate;
+
+            /**
+             * @brief Number of encoding threads
+             */
+            unsigned int threads;
+
+            /**
+             * @brief log2 of the number of token partitions (0 to 3),
+             * which lets the decoder use as many threads
+             */
+            unsigned int token_partitions;
+
+            /**
+             * @brief Speed/quality tradeoff, from -16 (fastest) to 16
+             */
+            int cpu_used;
+
+            /**
+             * @brief Rate control mode: VPX_CBR, VPX_VBR or VPX_CQ
+             */
+            vpx_rc_mode end_usage;
+
+            /**
+             * @brief Rate control buffer, in milliseconds
+             */
+            unsigned int buffer_ms;
+
+            /**
+             * @brief VPX_KF_AUTO to place keyframes, VPX_KF_DISABLED to only
+             * have the forced ones
+             */
+            vpx_kf_mode kf_mode;
+
+            /**
+             * @brief Maximum distance between two automatic keyframes
+             */
+            unsigned int kf_max_dist;
+        };
+
         /**
          * @brief Encode frames to FramePacket
          */
@@ -28,6 +90,12 @@ namespace Epyx
              */
             VpxEncoder(unsigned int display_width, unsigned int display_height,
                     unsigned int video_bitrate = 400);
+
+            /**
+             * @brief Constructor with a full configuration
+             * @param config
+             */
+            VpxEncoder(const VpxEncoderConfig& config);
             ~VpxEncoder();
 
             /**
@@ -43,6 +111,16 @@ namespace Epyx
              */
             bool encode(const vpx_image_t& raw, unsigned long time_ms, unsigned int flags);
 
+            /**
+             * @brief Change the bitrate and size of the next frames
+             * @param bitrate target bitrate in kbit/s
+             * @param width no larger than the initial width
+             * @param height no larger than the initial height
+             * @return true on success
+             */
+            bool reconfigure(unsigned int bitrate, unsigned int width,
+                    unsigned int height);
+
             /**
              * @brief Iterate over packets, until end (and return NULL)
              * @return unique_ptr to a packet
@@ -50,7 +128,10 @@ namespace Epyx
             std::unique_ptr<FramePacket> getPacket();
 
         private:
+            void init(const VpxEncoderConfig& config);
+
             vpx_codec_ctx_t encoder;
+            vpx_codec_enc_cfg_t cfg;
             vpx_codec_iter_t iter;
 
             unsigned int display_width;
@@ -1,35 +1,75 @@
 #include "autoresizeimageview.h"
+#include <boost/date_time/posix_time/posix_time.hpp>
 
 AutoResizeImageView::AutoResizeImageView(QWidget *parent) :
     QGraphicsView(parent),
     m_scene(new QGraphicsScene(this)),
     m_imageItem(0),
     m_border(0),
-    m_delayed(false)
+    m_delayed(false),
+    m_renders(0),
+    m_renderTime(0)
 {
     setScene(m_scene);
+    m_imageItem = m_scene->addPixmap(QPixmap());
+    QPen pen;
+    pen.setWidth(5);
+    pen.setColor(Qt::green);
+    m_border = m_scene->addRect(QRectF(), pen);
 }
 
 void AutoResizeImageView::setImage(const QImage &image) {
-    m_scene->clear();
-    m_imageItem = m_scene->addPixmap(QPixmap::fromImage(image));
-    QPen pen;
-    pen.setWidth(5);
-    if(m_delayed)
-	pen.setColor(Qt::red);
-    else
-	pen.setColor(Qt::green);
-    m_border = m_scene->addRect(m_imageItem->boundingRect(),pen);
-    fitInView(m_imageItem, Qt::KeepAspectRatio);
+    boost::posix_time::ptime start =
+        boost::posix_time::microsec_clock::local_time();
+
+    const bool resized = m_pixmap.size() != image.size();
+    // Same size frames are converted into the existing pixmap. The item
+    // shares it, so its copy is released first: otherwise converting would
+    // detach and deep copy the previous frame for nothing.
+    if(resized) {
+        m_pixmap = QPixmap::fromImage(image);
+    } else {
+        m_imageItem->setPixmap(QPixmap());
+        m_pixmap.convertFromImage(image);
+    }
+    m_imageItem->setPixmap(m_pixmap);
+
+    if(resized) {
+        m_border->setRect(m_imageItem->boundingRect());
+        m_scene->setSceneRect(m_border->boundingRect());
+        fitInView(m_imageItem, Qt::KeepAspectRatio);
+    }
+
+    m_renderTime += (boost::posix_time::microsec_clock::local_time() -
+                     start).total_microseconds();
+    m_renders++;
 }
 
 void AutoResizeImageView::resizeEvent(QResizeEvent *event)
 {
-    if(m_imageItem != 0)
+    if(!m_pixmap.isNull())
         fitInView(m_imageItem, Qt::KeepAspectRatio);
 }
 
 void AutoResizeImageView::setDelayed ( bool delayed )
 {
+    if(delayed == m_delayed)
+        return;
     m_delayed = delayed;
+    QPen pen = m_border->pen();
+    if(m_delayed)
+	pen.setColor(Qt::red);
+    else
+	pen.setColor(Qt::green);
+    m_border->setPen(pen);
+}
+
+unsigned long AutoResizeImageView::getRenderTime() const
+{
+    return m_renders ? m_renderTime / m_renders : 0;
+}
+
+unsigned long AutoResizeImageView::getRenderCount() const
+{
+    return m_renders;
 }
@@ -3,7 +3,9 @@
 
 #include <QGraphicsView>
 #include <QGraphicsScene>
-#include <QGraphicsItem>
+#include <QGraphicsPixmapItem>
+#include <QGraphicsRectItem>
+#include <QPixmap>
 #include <QResizeEvent>
 
 class AutoResizeImageView : public QGraphicsView
@@ -13,15 +15,24 @@ public:
     explicit AutoResizeImageView(QWidget *parent = 0);
     void setImage(const QImage &image);
     void setDelayed(bool delayed);
+    /**
+     * @brief Average time spent in setImage, in microseconds
+     */
+    unsigned long getRenderTime() const;
+    unsigned long getRenderCount() const;
     
 protected:
     void resizeEvent(QResizeEvent *event);
     
 private:
     QGraphicsScene* m_scene;
-    QGraphicsItem* m_imageItem;
-    QGraphicsItem* m_border;
+    // Both items live as long as the view and are updated in place
+    QGraphicsPixmapItem* m_imageItem;
+    QGraphicsRectItem* m_border;
+    QPixmap m_pixmap;
     bool m_delayed;
+    unsigned long m_renders;
+    unsigned long m_renderTime;
 };
 
 #endif // AUTORESIZEIMAGEVIEW_H
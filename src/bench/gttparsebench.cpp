@@ -0,0 +1,92 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+
+/**
+ * @file gttparsebench.cpp
+ * @brief Parse a stream of GTT packets through GTTParser and LineParser, as
+ * a TCP connection would deliver it
+ */
+
+#include "parser/gttparser.h"
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <iostream>
+#include <cstdlib>
+
+using namespace Epyx;
+using namespace boost::posix_time;
+
+int main ( int argc, char* argv[] )
+{
+    if ( argc > 4 ) {
+        std::cout << "Use : gtt_parse_bench [mebibytes=100] [body=1400]"
+                  " [chunk=65536]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const unsigned long total = ( argc >= 2 ? std::atol ( argv[1] ) : 100 )
+                                * 1024 * 1024;
+    const unsigned int bodySize = argc >= 3 ? std::atoi ( argv[2] ) : 1400;
+    const unsigned int chunkSize = argc >= 4 ? std::atoi ( argv[3] ) : 65536;
+    if ( total == 0 || bodySize == 0 || chunkSize == 0 ) {
+        std::cout << "Error: arguments must be positive" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // A fragment-like packet, repeated in a buffer of at least one chunk
+    GTTPacket packet;
+    packet.protocol = "VCP2P";
+    packet.method = "FRAGMENT";
+    packet.headers["Time"] = "2012-Dec-31 23:59:59.999999";
+    packet.headers["Frame"] = "4294967295";
+    packet.headers["Number"] = "65535";
+    packet.headers["Count"] = "65535";
+    packet.headers["Source"] = "127.0.0.1:10000";
+    packet.body.assign ( bodySize, 'x' );
+    const byte_str raw = packet.build();
+    byte_str stream;
+    while ( stream.size() < chunkSize )
+        stream += raw;
+    const unsigned long streamPackets = stream.size() / raw.size();
+
+    GTTParser parser;
+    unsigned long fed = 0;
+    unsigned long parsed = 0;
+    const ptime start = microsec_clock::local_time();
+    while ( fed < total ) {
+        // Chunks cut packets at arbitrary places, like TCP segments
+        for ( size_t offset = 0; offset < stream.size(); offset += chunkSize )
+            parser.eat ( stream.substr ( offset, chunkSize ) );
+        fed += stream.size();
+        while ( parser.getPacket() )
+            parsed++;
+    }
+    const double us = ( microsec_clock::local_time() - start )
+                      .total_microseconds();
+
+    std::string error;
+    if ( parser.getError ( error ) || parsed != fed / raw.size() ||
+            parsed % streamPackets != 0 ) {
+        std::cout << "Error: " << parsed << " packets parsed, " << error
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+    // Sizes in MiB, as given on the command line
+    const double mib = fed / ( 1024.0 * 1024.0 );
+    std::cout << parsed << " packets, " << mib << " MiB in " << us / 1000
+              << " ms, " << mib * 1000000 / us << " MiB/s" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,108 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+
+/**
+ * @file udpbatchbench.cpp
+ * @brief Compare sending datagrams one by one with sendto and in batches
+ * with sendmmsg, over the loopback interface
+ */
+
+#include "net/udpsocket.h"
+#include "net/sockaddress.h"
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace Epyx;
+using namespace boost::posix_time;
+
+/**
+ * @brief Print the cost of sending count datagrams
+ */
+static void report ( const std::string& name, unsigned int count,
+                     const time_duration& elapsed )
+{
+    const double us = elapsed.total_microseconds();
+    std::cout << name << ": " << count << " datagrams in " << us / 1000
+              << " ms, " << us / count << " us per datagram" << std::endl;
+}
+
+int main ( int argc, char* argv[] )
+{
+    if ( argc > 4 ) {
+        std::cout << "Use : udp_batch_bench [datagrams=100000] [size=1400]"
+                  " [batch=64]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const unsigned int count = argc >= 2 ? std::atoi ( argv[1] ) : 100000;
+    const unsigned int size = argc >= 3 ? std::atoi ( argv[2] ) : 1400;
+    const unsigned int batchSize = argc >= 4 ? std::atoi ( argv[3] ) : 64;
+    if ( count == 0 || size == 0 || batchSize == 0 ) {
+        std::cout << "Error: arguments must be positive" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Nobody reads the sink, datagrams over its buffer are dropped
+    const int sink = ::socket ( AF_INET, SOCK_DGRAM, 0 );
+    struct sockaddr_in saddr;
+    memset ( &saddr, 0, sizeof ( saddr ) );
+    saddr.sin_family = AF_INET;
+    saddr.sin_addr.s_addr = htonl ( INADDR_LOOPBACK );
+    socklen_t length = sizeof ( saddr );
+    if ( sink < 0 || ::bind ( sink, ( struct sockaddr * ) &saddr,
+                              sizeof ( saddr ) ) < 0 ||
+            ::getsockname ( sink, ( struct sockaddr * ) &saddr, &length ) < 0 ) {
+        std::cout << "Error: cannot bind the loopback sink" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const SockAddress address ( ( const struct sockaddr * ) &saddr );
+
+    UDPSocket sock;
+    const std::vector<byte> payload ( size, 0x42 );
+
+    ptime start = microsec_clock::local_time();
+    for ( unsigned int i = 0; i < count; i++ )
+        sock.sendTo ( address, &payload[0], size );
+    report ( "sendto", count, microsec_clock::local_time() - start );
+
+    std::vector<UDPDatagram> batch;
+    batch.reserve ( batchSize );
+    start = microsec_clock::local_time();
+    for ( unsigned int sent = 0; sent < count; sent += batch.size() ) {
+        batch.clear();
+        for ( unsigned int i = sent; i < count &&
+                batch.size() < batchSize; i++ ) {
+            UDPDatagram dgram;
+            dgram.address = address;
+            dgram.iov[0].iov_base = const_cast<byte*> ( &payload[0] );
+            dgram.iov[0].iov_len = size;
+            dgram.iovcnt = 1;
+            batch.push_back ( dgram );
+        }
+        sock.sendBatch ( batch );
+    }
+    report ( "sendmmsg", count, microsec_clock::local_time() - start );
+
+    ::close ( sink );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+
+/**
+ * @file fragmentmtucheck.cpp
+ * @brief Check that every fragment datagram the sender emits fits the MTU
+ *
+ * Frames are cut as Sender does, with the fragment size left by the header
+ * bound of the wire formats in use, for every MTU a conference accepts.
+ * Data and parity fragments are checked in both wire formats.
+ */
+
+#include "fragmentmanager.h"
+#include "receiver.h"
+#include "sender.h"
+#include "videoconferencep2p.h"
+#include <iostream>
+#include <cstdlib>
+
+static unsigned long checked = 0;
+static unsigned long failed = 0;
+
+/**
+ * @brief Cut a frame and check the datagrams of its fragments
+ *
+ * @param formats wire formats whose headers the fragment size allows for
+ */
+static void checkFrame ( unsigned int mtu, const SockAddress& source,
+                         const bool formats[2], unsigned int frameSize,
+                         unsigned int frameId, unsigned int repairCount )
+{
+    size_t header = 0;
+    for ( int f = wireGtt; f <= wireBinary; f++ ) {
+        if ( formats[f] )
+            header = std::max ( header, FragmentPacket::maxHeaderSize (
+                                    ( WireFormat ) f, source ) );
+    }
+    const unsigned int fragmentSize = mtu - Sender::datagramOverhead - header;
+
+    std::shared_ptr<byte_str> frame ( new byte_str ( frameSize, 0 ) );
+    std::vector<FragmentPacket> list =
+        FragmentManager::cut ( frame, frameId, fragmentSize, repairCount );
+    for ( auto fp = list.begin(); fp != list.end(); fp++ ) {
+        fp->source = source;
+        for ( int f = wireGtt; f <= wireBinary; f++ ) {
+            if ( !formats[f] )
+                continue;
+            const size_t size = fp->buildHeader ( ( WireFormat ) f ).size() +
+                                fp->payloadSize();
+            checked++;
+            if ( size + Sender::datagramOverhead <= mtu )
+                continue;
+            if ( failed++ < 10 ) {
+                std::cout << "Error: " << size << " bytes datagram over MTU "
+                          << mtu << ", format " << f << ", source " << source
+                          << ", frame " << frameId << " of " << frameSize
+                          << " bytes, fragment " << fp->fragmentNumber
+                          << " of " << fp->fragmentCount << " + "
+                          << repairCount << " parity" << std::endl;
+            }
+        }
+    }
+}
+
+int main()
+{
+    const SockAddress sources[] = {
+        SockAddress ( "127.0.0.1", 1 ),
+        SockAddress ( "255.255.255.255", 65535 )
+    };
+    const bool formatSets[3][2] = {
+        { true, false }, { false, true }, { true, true }
+    };
+    const unsigned int repairCounts[] = { 0, 3, 255 };
+
+    for ( unsigned int mtu = VideoConferenceP2P::minMtu;
+            mtu <= Receiver::datagramSize; mtu++ ) {
+        for ( const SockAddress& source : sources ) {
+            for ( const bool* formats : formatSets ) {
+                for ( unsigned int repair : repairCounts ) {
+                    // Frames around the fragment size
+                    const unsigned int sizes[] = {
+                        1, mtu / 2, mtu - 1, mtu, mtu + 1, 3 * mtu + 7
+                    };
+                    for ( unsigned int size : sizes )
+                        checkFrame ( mtu, source, formats, size, 0xffffffff,
+                                     repair );
+                }
+            }
+        }
+    }
+
+    // Keyframes, and the longest fragment numbers with frames filling the
+    // whole reassembly window
+    const unsigned int mtus[] = { VideoConferenceP2P::minMtu, 1500,
+                                  Receiver::datagramSize };
+    for ( unsigned int mtu : mtus ) {
+        for ( const bool* formats : formatSets ) {
+            checkFrame ( mtu, sources[1], formats, 40000, 0, 3 );
+            checkFrame ( mtu, sources[1], formats, FragmentManager::maxBytes,
+                         0, 255 );
+        }
+    }
+
+    if ( failed > 0 ) {
+        std::cout << failed << " of " << checked
+                  << " datagrams over the MTU" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << checked << " datagrams within the MTU" << std::endl;
+    return EXIT_SUCCESS;
+}
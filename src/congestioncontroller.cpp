@@ -0,0 +1,117 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+#include "congestioncontroller.h"
+#include "core/log.h"
+#include <algorithm>
+
+const unsigned int CongestionController::minBitrate;
+const unsigned int CongestionController::maxRepairRate;
+
+CongestionController::CongestionController ( unsigned int maxBitrate ) :
+    maxBitrate ( maxBitrate )
+{
+    target.bitrate = maxBitrate;
+    target.scale = 1;
+    target.repairRate = 0;
+}
+
+void CongestionController::report ( const SockAddress& peer, unsigned int rtt,
+                                    unsigned long completed,
+                                    unsigned long lost,
+                                    unsigned long recovered )
+{
+    std::lock_guard<std::mutex> lock ( mutex );
+
+    auto it = peers.find ( peer );
+    if ( it == peers.end() ) {
+        Peer p;
+        p.completed = completed;
+        p.lost = lost;
+        p.recovered = recovered;
+        p.minRtt = rtt;
+        p.bitrate = maxBitrate;
+        p.damaged = 0;
+        peers.insert ( std::make_pair ( peer, p ) );
+        return;
+    }
+
+    Peer& p = it->second;
+    // Counters restart when the peer restarts
+    const unsigned long newCompleted =
+        completed >= p.completed ? completed - p.completed : completed;
+    const unsigned long newLost = lost >= p.lost ? lost - p.lost : lost;
+    const unsigned long newRecovered =
+        recovered >= p.recovered ? recovered - p.recovered : recovered;
+    p.completed = completed;
+    p.lost = lost;
+    p.recovered = recovered;
+    p.minRtt = std::min ( p.minRtt, rtt );
+
+    const double loss = newCompleted + newLost > 0 ?
+                        double ( newLost ) / ( newCompleted + newLost ) : 0;
+    const bool queuing = rtt > 2 * p.minRtt + 50;
+    if ( newCompleted + newLost > 0 )
+        p.damaged += ( double ( newLost + newRecovered ) /
+                       ( newCompleted + newLost ) - p.damaged ) / 4;
+
+    if ( loss > 0.1 )
+        p.bitrate *= 1 - loss / 2;
+    else if ( queuing )
+        p.bitrate = p.bitrate * 85 / 100;
+    else if ( loss < 0.02 )
+        p.bitrate = p.bitrate * 108 / 100 + 1;
+    p.bitrate = std::max ( minBitrate, std::min ( maxBitrate, p.bitrate ) );
+
+    unsigned int bitrate = maxBitrate;
+    double damaged = 0;
+    for ( auto peer = peers.begin(); peer != peers.end(); peer++ ) {
+        bitrate = std::min ( bitrate, peer->second.bitrate );
+        damaged = std::max ( damaged, peer->second.damaged );
+    }
+
+    // As many parity fragments as damaged frames, roughly, which covers
+    // isolated losses; none on a clean network
+    const unsigned int repairRate = damaged < 0.005 ? 0 :
+                                    std::min<unsigned int> ( maxRepairRate,
+                                            std::max ( 5.0, damaged * 100 ) );
+
+    // Fewer pixels look better than starved ones, with some hysteresis
+    unsigned int scale = target.scale;
+    if ( bitrate < maxBitrate / 4 )
+        scale = 2;
+    else if ( bitrate > maxBitrate / 2 )
+        scale = 1;
+
+    if ( bitrate != target.bitrate || scale != target.scale ||
+            repairRate != target.repairRate ) {
+        Epyx::log::debug << "Congestion: " << loss * 100 << "% lost, RTT "
+                         << rtt << " ms, sending " << bitrate << " kbit/s"
+                         << ( scale > 1 ? " at half size" : "" )
+                         << " with " << repairRate << "% parity"
+                         << Epyx::log::endl;
+    }
+    target.bitrate = bitrate;
+    target.scale = scale;
+    target.repairRate = repairRate;
+}
+
+VideoTarget CongestionController::getTarget() const
+{
+    std::lock_guard<std::mutex> lock ( mutex );
+    return target;
+}
@@ -0,0 +1,98 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+#ifndef CONGESTIONCONTROLLER_H
+#define CONGESTIONCONTROLLER_H
+
+#include "net/sockaddress.h"
+#include <map>
+#include <mutex>
+
+using namespace Epyx;
+
+/**
+ * @brief Video settings chosen by the CongestionController
+ */
+struct VideoTarget {
+    /** Bitrate in kbit/s */
+    unsigned int bitrate;
+    /** The video is divided by this factor in both dimensions */
+    unsigned int scale;
+    /** Parity fragments to add, in percent of the data fragments */
+    unsigned int repairRate;
+};
+
+/**
+ * @brief Adapt the sent video to the worst receiver
+ *
+ * Receivers report how many of our frames they completed and lost along
+ * with their RTT replies. Each receiver gets its own bitrate estimate: it
+ * backs off on losses above 10% or on a growing RTT and probes upwards
+ * below 2% of losses. The video follows the lowest estimate, and its size
+ * is halved when the bitrate gets too low for the full resolution.
+ *
+ * Frames recovered by parity count as lost when sizing the parity, so
+ * that the parity does not vanish as soon as it starts working.
+ */
+class CongestionController {
+public:
+    /**
+     * @param maxBitrate bitrate at full resolution without congestion
+     */
+    CongestionController ( unsigned int maxBitrate );
+
+    /**
+     * @brief Account for the report of a receiver
+     * @param peer the receiver
+     * @param rtt round trip time in ms
+     * @param completed frames received by the peer so far
+     * @param lost frames the peer lost, incomplete or whole, so far
+     * @param recovered frames the peer completed with parity so far
+     */
+    void report ( const SockAddress& peer, unsigned int rtt,
+                  unsigned long completed, unsigned long lost,
+                  unsigned long recovered );
+
+    VideoTarget getTarget() const;
+
+    /**
+     * @brief Lowest bitrate ever asked, in kbit/s
+     */
+    static const unsigned int minBitrate = 50;
+    /**
+     * @brief Highest parity rate, in percent
+     */
+    static const unsigned int maxRepairRate = 50;
+
+private:
+    struct Peer {
+        unsigned long completed;
+        unsigned long lost;
+        unsigned long recovered;
+        unsigned int minRtt;
+        unsigned int bitrate;
+        // Smoothed share of frames which missed fragments
+        double damaged;
+    };
+
+    unsigned int maxBitrate;
+    std::map<SockAddress, Peer> peers;
+    VideoTarget target;
+    mutable std::mutex mutex;
+};
+
+#endif // CONGESTIONCONTROLLER_H
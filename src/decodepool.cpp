@@ -0,0 +1,70 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+#include "decodepool.h"
+#include "user.h"
+#include "core/log.h"
+
+const unsigned int statsInterval = 24 * 10;
+
+DecodeJob::DecodeJob ( User* user ) : user ( user )
+{
+}
+
+DecodePool::DecodePool ( int num_workers ) :
+    WorkerPool<DecodeJob> ( num_workers, "Decoder" ),
+    decoded ( 0 ), skipped ( 0 ), totalLatency ( 0 ), maxQueueDepth ( 0 )
+{
+}
+
+void DecodePool::treat ( std::unique_ptr<DecodeJob> job )
+{
+    job->user->decodePending ( *this );
+}
+
+void DecodePool::recordDecode ( unsigned long latency,
+                                unsigned int queueDepth )
+{
+    totalLatency += latency;
+    unsigned int depth = maxQueueDepth;
+    while ( queueDepth > depth &&
+            !maxQueueDepth.compare_exchange_weak ( depth, queueDepth ) );
+
+    if ( ++decoded % statsInterval == 0 ) {
+        const DecodeStats stats = getStats();
+        Epyx::log::debug << "Decoder: " << stats.decoded << " frames, "
+                         << stats.averageLatency << " us per frame, "
+                         << stats.skipped << " skipped, "
+                         << "queue depth up to " << stats.maxQueueDepth
+                         << Epyx::log::endl;
+    }
+}
+
+void DecodePool::recordSkipped ( unsigned int count )
+{
+    skipped += count;
+}
+
+DecodeStats DecodePool::getStats() const
+{
+    DecodeStats stats;
+    stats.decoded = decoded;
+    stats.skipped = skipped;
+    stats.averageLatency = stats.decoded ? totalLatency / stats.decoded : 0;
+    stats.maxQueueDepth = maxQueueDepth;
+    return stats;
+}
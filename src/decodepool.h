@@ -0,0 +1,85 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+#ifndef DECODEPOOL_H
+#define DECODEPOOL_H
+
+#include "core/worker-pool.h"
+#include <atomic>
+
+class User;
+
+using namespace Epyx;
+
+/**
+ * @brief Ask a worker to decode the pending frames of a user
+ */
+struct DecodeJob {
+    DecodeJob ( User* user );
+    User* user;
+};
+
+/**
+ * @brief Decoding statistics
+ */
+struct DecodeStats {
+    /** Number of decoded frames */
+    unsigned long decoded;
+    /** Number of frames dropped without being decoded */
+    unsigned long skipped;
+    /** Average decode time, in microseconds */
+    unsigned long averageLatency;
+    /** Largest number of frames waiting for one user */
+    unsigned int maxQueueDepth;
+};
+
+/**
+ * @brief Workers which decode completed frames off the receiver thread
+ *
+ * Every user has its own queue of frames to decode. A user is handled by
+ * at most one worker at a time, which keeps its frames in order, while the
+ * workers are shared among all users.
+ */
+class DecodePool : public WorkerPool<DecodeJob> {
+public:
+    DecodePool ( int num_workers );
+
+    /**
+     * @brief Account for one decoded frame
+     * @param latency decode time in microseconds
+     * @param queueDepth frames which were waiting for the same user
+     */
+    void recordDecode ( unsigned long latency, unsigned int queueDepth );
+
+    /**
+     * @brief Account for frames which were never displayed, hence not decoded
+     */
+    void recordSkipped ( unsigned int count );
+
+    DecodeStats getStats() const;
+
+protected:
+    void treat ( std::unique_ptr<DecodeJob> job );
+
+private:
+    std::atomic<unsigned long> decoded;
+    std::atomic<unsigned long> skipped;
+    std::atomic<unsigned long> totalLatency;
+    std::atomic<unsigned int> maxQueueDepth;
+};
+
+#endif // DECODEPOOL_H
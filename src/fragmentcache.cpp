@@ -0,0 +1,58 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+
+#include "fragmentcache.h"
+
+bool CachedFrame::buildHeader ( unsigned int fragment, WireFormat format )
+{
+    std::vector<byte_str>& built = headers[format];
+    if ( built.size() != fragments.size() )
+        built.resize ( fragments.size() );
+    if ( !built[fragment].empty() )
+        return false;
+    built[fragment] = fragments[fragment].buildHeader ( format );
+    return true;
+}
+
+FragmentCache::FragmentCache ( unsigned int maxFrames ) :
+    maxFrames ( maxFrames )
+{
+}
+
+void FragmentCache::store ( unsigned int frameId,
+                            const std::shared_ptr<CachedFrame>& frame )
+{
+    std::lock_guard<std::mutex> lock ( mutex );
+    if ( frames.find ( frameId ) == frames.end() )
+        order.push_back ( frameId );
+    frames[frameId] = frame;
+
+    while ( order.size() > maxFrames ) {
+        frames.erase ( order.front() );
+        order.pop_front();
+    }
+}
+
+std::shared_ptr<CachedFrame> FragmentCache::find ( unsigned int frameId ) const
+{
+    std::lock_guard<std::mutex> lock ( mutex );
+    auto it = frames.find ( frameId );
+    if ( it == frames.end() )
+        return std::shared_ptr<CachedFrame>();
+    return it->second;
+}
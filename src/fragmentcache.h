@@ -0,0 +1,80 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+
+#ifndef FRAGMENTCACHE_H
+#define FRAGMENTCACHE_H
+
+#include "packets/fragmentpacket.h"
+#include <map>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Fragments of a sent frame, with their serialized headers
+ *
+ * Headers are serialized at most once per fragment and wire format, by the
+ * Sender before the frame is cached and by the single thread serving the
+ * retransmissions afterwards.
+ */
+struct CachedFrame {
+    std::vector<FragmentPacket> fragments;
+    // Serialized headers by wire format, empty until built
+    std::vector<byte_str> headers[2];
+
+    /**
+     * @brief Get the header of a fragment, serializing it if needed
+     * @return whether the header had to be serialized
+     */
+    bool buildHeader ( unsigned int fragment, WireFormat format );
+};
+
+/**
+ * @brief Keep the last frames sent, to retransmit their lost fragments
+ *
+ * Frames are shared, so a retransmission may keep using a frame which was
+ * evicted meanwhile.
+ */
+class FragmentCache {
+public:
+    /**
+     * @param maxFrames number of frames kept
+     */
+    FragmentCache ( unsigned int maxFrames = 64 );
+
+    /**
+     * @brief Add a frame, evicting the oldest ones if needed
+     */
+    void store ( unsigned int frameId,
+                 const std::shared_ptr<CachedFrame>& frame );
+
+    /**
+     * @brief Find a frame which was sent recently
+     * @return the frame, or NULL if it was evicted
+     */
+    std::shared_ptr<CachedFrame> find ( unsigned int frameId ) const;
+
+private:
+    unsigned int maxFrames;
+    std::map<unsigned int, std::shared_ptr<CachedFrame> > frames;
+    std::deque<unsigned int> order;
+    mutable std::mutex mutex;
+};
+
+#endif // FRAGMENTCACHE_H
@@ -17,33 +17,134 @@
 
 #include "fragmentlist.h"
 #include <string.h>
+#include <algorithm>
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 
-FragmentList::FragmentList()
+const unsigned int FragmentList::maxFragments;
+
+FragmentList::FragmentList() :
+    fragmentCount(0), fragmentSize(0), receivedCount(0), receivedEnd(0),
+    repairCount(0), recovered(false)
 {
 }
 
-FragmentList::FragmentList ( unsigned int packetSize,
-			     ptime packetTimestamp ) :
-    packetTimestamp(packetTimestamp), data(packetSize, ' ')
+FragmentList::FragmentList ( byte_str& buffer,
+			     unsigned int fragmentCount,
+			     unsigned int fragmentSize,
+			     unsigned int repairCount,
+			     ptime packetTimestamp,
+			     ptime arrivalTime ) :
+    packetTimestamp(packetTimestamp), arrivalTime(arrivalTime),
+    fragmentCount(std::min(fragmentCount, maxFragments)),
+    fragmentSize(fragmentSize), receivedCount(0), receivedEnd(0),
+    repairCount(std::min(repairCount, this->fragmentCount)),
+    repairs(this->repairCount), recovered(false)
 {
-    for(int i = 0; i < packetSize/1500 + (packetSize%150 != 0?1:0); i++)
-	missingPackets.insert(i);
+    data.swap(buffer);
 }
 
 void FragmentList::addFragment ( const FragmentPacket& p )
 {
-    data.replace(1500*p.fragmentNumber, p.data.size(), p.data);
-    missingPackets.erase(p.fragmentNumber);
+    receivedEnd = std::max(receivedEnd, p.fragmentNumber + 1u);
+
+    if (p.fragmentNumber >= fragmentCount) {
+        const unsigned int group = p.fragmentNumber - fragmentCount;
+        if (group >= repairCount || !repairs[group].empty()
+                || p.payloadSize() > fragmentSize)
+            return;
+        repairs[group].assign(p.payload(), p.payloadSize());
+        recover(group);
+        return;
+    }
+
+    const size_t offset = fragmentSize * p.fragmentNumber;
+    if (received.test(p.fragmentNumber)
+            || offset + p.payloadSize() > data.size())
+        return;
+
+    memcpy(&data[offset], p.payload(), p.payloadSize());
+    received.set(p.fragmentNumber);
+    receivedCount++;
+    if (repairCount > 0)
+        recover(p.fragmentNumber % repairCount);
+}
+
+/**
+ * @brief Rebuild the missing fragment of a group, if it is the only one
+ */
+void FragmentList::recover ( unsigned int group )
+{
+    const byte_str& parity = repairs[group];
+    if (parity.empty())
+        return;
+
+    unsigned int missing = fragmentCount;
+    for (unsigned int i = group; i < fragmentCount; i += repairCount) {
+        if (received.test(i))
+            continue;
+        if (missing != fragmentCount)
+            return;
+        missing = i;
+    }
+    if (missing == fragmentCount)
+        return;
+
+    const size_t offset = fragmentSize * missing;
+    if (offset >= data.size())
+        return;
+    const size_t length = std::min<size_t>(fragmentSize, data.size() - offset);
+    if (length > parity.size())
+        return;
+    byte* out = &data[offset];
+    memcpy(out, parity.data(), length);
+    for (unsigned int i = group; i < fragmentCount; i += repairCount) {
+        if (i == missing)
+            continue;
+        const byte* in = &data[fragmentSize * i];
+        const size_t n = std::min<size_t>(length, data.size() - fragmentSize * i);
+        for (size_t k = 0; k < n; k++)
+            out[k] ^= in[k];
+    }
+
+    received.set(missing);
+    receivedCount++;
+    recovered = true;
 }
 
 bool FragmentList::isComplete() const
 {
-    return missingPackets.empty();
+    return receivedCount == fragmentCount;
 }
 
-byte_str FragmentList::getData() const
+bool FragmentList::isRecovered() const
 {
-    return data;
-}
\ No newline at end of file
+    return recovered;
+}
+
+void FragmentList::takeData ( byte_str& buffer )
+{
+    buffer.swap(data);
+    data.clear();
+}
+
+unsigned int FragmentList::getSize() const
+{
+    return data.size();
+}
+
+void FragmentList::getMissing ( std::vector<unsigned short>& numbers,
+                                unsigned int max,
+                                unsigned int end ) const
+{
+    end = std::min(end, fragmentCount);
+    for (unsigned int i = 0; i < end && numbers.size() < max; i++) {
+        if (!received.test(i))
+            numbers.push_back(i);
+    }
+}
+
+unsigned int FragmentList::getReceivedEnd() const
+{
+    return receivedEnd;
+}
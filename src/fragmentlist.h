@@ -18,22 +18,81 @@
 #ifndef FRAGMENTLIST_H
 #define FRAGMENTLIST_H
 
-#include <set>
+#include <bitset>
+#include <vector>
 #include "packets/fragmentpacket.h"
 
 class FragmentList {
     typedef boost::posix_time::ptime ptime;
 public:
+    /**
+     * @brief Maximum number of fragments in a frame
+     */
+    static const unsigned int maxFragments = 1024;
+
     FragmentList();
-    FragmentList(unsigned int packetSize, ptime packetTimestamp);
+    /**
+     * @brief Start a frame in a buffer, usually taken from a FrameBufferPool
+     * @param buffer buffer of the frame size, which is SWAPPED in
+     * @param fragmentCount number of data fragments of the frame
+     * @param fragmentSize payload size of the data fragments
+     * @param repairCount number of parity fragments of the frame
+     */
+    FragmentList(byte_str& buffer, unsigned int fragmentCount,
+                 unsigned int fragmentSize, unsigned int repairCount,
+                 ptime packetTimestamp, ptime arrivalTime);
+    /**
+     * @brief Add a data or parity fragment
+     *
+     * A data fragment missing from a parity group is rebuilt as soon as the
+     * parity and every other fragment of the group are there.
+     */
     void addFragment(const FragmentPacket &p);
     bool isComplete() const;
-    byte_str getData() const;
+    /**
+     * @brief Whether some fragments were rebuilt from parity
+     */
+    bool isRecovered() const;
+    /**
+     * @brief Move the frame data out of this list
+     */
+    void takeData(byte_str& buffer);
+    unsigned int getSize() const;
+    /**
+     * @brief Get the numbers of the data fragments not received yet
+     * @param max maximum number of fragments returned
+     * @param end only the fragments numbered below end are returned
+     */
+    void getMissing(std::vector<unsigned short>& numbers,
+                    unsigned int max, unsigned int end = maxFragments) const;
+    /**
+     * @brief Number following the highest data or parity fragment received
+     *
+     * Fragments are sent in order, so missing fragments below this number
+     * were lost or reordered, while the others may not be sent yet.
+     */
+    unsigned int getReceivedEnd() const;
     ptime packetTimestamp;
+    ptime arrivalTime;
+    /**
+     * @brief Last time the missing fragments were asked again, if ever
+     */
+    ptime lastNack;
     
 private:
-    std::set<unsigned char> missingPackets;
+    void recover(unsigned int group);
+
+    std::bitset<maxFragments> received;
+    unsigned int fragmentCount;
+    unsigned int fragmentSize;
+    unsigned int receivedCount;
+    unsigned int receivedEnd;
     byte_str data;
+
+    unsigned int repairCount;
+    // Parity fragments, empty until received
+    std::vector<byte_str> repairs;
+    bool recovered;
 };
 
 #endif // FRAGMENTLIST_H
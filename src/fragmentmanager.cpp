@@ -16,56 +16,295 @@
 
 
 #include "fragmentmanager.h"
+#include "packets/nackpacket.h"
 
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <algorithm>
 
-FragmentManager::FragmentManager()
+// Number of finished frame ids remembered to drop their stray fragments
+const unsigned int finishedHistory = 64;
+
+FragmentManager::FragmentManager() :
+    bytes ( 0 ), hasLastComplete ( false ), lastComplete ( 0 ),
+    hasNewest ( false ), newest ( 0 ), completed ( 0 ), late ( 0 ),
+    abandoned ( 0 ), missing ( 0 ), recovered ( 0 )
 {
 }
 
 void FragmentManager::eat ( FragmentPacket& fp )
 {
-    if ( fragmentList.packetTimestamp != fp.packetTimestamp )
-        fragmentList = FragmentList ( fp.packetSize, fp.packetTimestamp );
+    const ptime now = boost::posix_time::microsec_clock::local_time();
+
+    // Fragment of a frame which was already completed or abandoned
+    if ( std::find ( finished.begin(), finished.end(), fp.frameId ) !=
+            finished.end() )
+        return;
+
+    auto it = fragmentLists.find ( fp.frameId );
+    if ( it == fragmentLists.end() ) {
+        // Frames from peers without a fragment count cannot be rebuilt, and
+        // frames larger than the whole window would evict everything
+        if ( fp.packetSize == 0 || fp.packetSize > maxBytes ||
+                fp.fragmentCount == 0 ||
+                fp.fragmentCount > FragmentList::maxFragments ||
+                fp.fragmentSize == 0 ||
+                fp.fragmentCount != ( fp.packetSize + fp.fragmentSize - 1 ) /
+                fp.fragmentSize )
+            return;
+        expect ( fp.frameId, now );
+        byte_str buffer = pool.acquire ( fp.packetSize );
+        it = fragmentLists.emplace ( fp.frameId,
+                                     FragmentList ( buffer, fp.fragmentCount,
+                                             fp.fragmentSize, fp.repairCount,
+                                             fp.packetTimestamp, now ) ).first;
+        bytes += fp.packetSize;
+        evict ( now );
+        release();
+        it = fragmentLists.find ( fp.frameId );
+        if ( it == fragmentLists.end() )
+            return;
+    }
+
+    it->second.addFragment ( fp );
+    if ( !it->second.isComplete() )
+        return;
+
+    // The frame keeps the reassembly buffer until it is decoded
+    bytes -= it->second.getSize();
+    byte_str data;
+    it->second.takeData ( data );
+    Frame frame ( data, now, it->second.packetTimestamp );
+    if ( frame.isJpeg() )
+        completeFrames.push_back ( std::move ( frame ) );
+    else
+        held.emplace ( fp.frameId, std::move ( frame ) );
+    completed++;
+    if ( it->second.isRecovered() )
+        recovered++;
+    if ( hasLastComplete && fp.frameId < lastComplete )
+        late++;
+    else
+        lastComplete = fp.frameId;
+    hasLastComplete = true;
+
+    finish ( fp.frameId );
+    fragmentLists.erase ( it );
+    release();
+}
+
+/**
+ * @brief Give the held frames which no older frame is waited for anymore
+ */
+void FragmentManager::release()
+{
+    while ( !held.empty() ) {
+        const unsigned int frameId = held.begin()->first;
+        if ( ( !fragmentLists.empty() &&
+                fragmentLists.begin()->first < frameId ) ||
+                ( !expected.empty() && expected.begin()->first < frameId ) )
+            return;
+        completeFrames.push_back ( std::move ( held.begin()->second ) );
+        held.erase ( held.begin() );
+    }
+}
+
+/**
+ * @brief Account for the first fragment of a frame
+ *
+ * Frames skipped by the frame ids may still arrive reordered, so they are
+ * only counted as missing once evicted like incomplete frames.
+ */
+void FragmentManager::expect ( unsigned int frameId, const ptime& now )
+{
+    if ( hasNewest && frameId <= newest ) {
+        expected.erase ( frameId );
+        return;
+    }
+
+    if ( hasNewest ) {
+        // Gaps longer than the history are not worth waiting for
+        unsigned int first = newest + 1;
+        if ( frameId - first > finishedHistory ) {
+            missing += frameId - first - finishedHistory;
+            first = frameId - finishedHistory;
+        }
+        for ( unsigned int id = first; id < frameId; id++ )
+            expected[id] = now;
+    }
+    hasNewest = true;
+    newest = frameId;
+}
+
+/**
+ * @brief Drop the oldest incomplete frames while the window is too large
+ */
+void FragmentManager::evict ( const ptime& now )
+{
+    for ( auto it = fragmentLists.begin(); it != fragmentLists.end(); ) {
+        if ( ( now - it->second.arrivalTime ).total_milliseconds() > maxAge )
+            abandon ( it++ );
+        else
+            it++;
+    }
+
+    for ( auto it = expected.begin(); it != expected.end(); ) {
+        if ( expected.size() > finishedHistory ||
+                ( now - it->second ).total_milliseconds() > maxAge ) {
+            missing++;
+            finish ( it->first );
+            expected.erase ( it++ );
+        } else {
+            it++;
+        }
+    }
+
+    while ( !fragmentLists.empty() &&
+            ( fragmentLists.size() > maxFrames || bytes > maxBytes ) ) {
+        abandon ( fragmentLists.begin() );
+    }
+
+    // Frames held behind an older one count in the window too, so that a
+    // lost frame does not stall the video until maxAge
+    while ( held.size() > maxFrames ) {
+        const unsigned int frameId = held.begin()->first;
+        if ( !expected.empty() && expected.begin()->first < frameId ) {
+            missing++;
+            finish ( expected.begin()->first );
+            expected.erase ( expected.begin() );
+        } else if ( !fragmentLists.empty() &&
+                    fragmentLists.begin()->first < frameId ) {
+            abandon ( fragmentLists.begin() );
+        }
+        release();
+    }
+}
+
+void FragmentManager::abandon ( std::map<unsigned int, FragmentList>::iterator it )
+{
+    abandoned++;
+    finish ( it->first );
+    bytes -= it->second.getSize();
+    byte_str data;
+    it->second.takeData ( data );
+    pool.release ( data );
+    fragmentLists.erase ( it );
+}
 
-    fragmentList.addFragment ( fp );
+/**
+ * @brief Drop the fragments of the given frame from now on
+ */
+void FragmentManager::finish ( unsigned int frameId )
+{
+    finished.push_back ( frameId );
+    if ( finished.size() > finishedHistory )
+        finished.pop_front();
+}
+
+void FragmentManager::getNacks ( const ptime& now,
+                                 unsigned int retryInterval,
+                                 std::vector<FragmentNack>& nacks )
+{
+    if ( fragmentLists.empty() )
+        return;
+
+    unsigned int newest = fragmentLists.rbegin()->first;
+    if ( hasLastComplete )
+        newest = std::max ( newest, lastComplete );
+
+    for ( auto it = fragmentLists.begin(); it != fragmentLists.end(); it++ ) {
+        FragmentList& list = it->second;
+        const bool sending = it->first >= newest;
+        if ( sending &&
+                ( now - list.arrivalTime ).total_milliseconds() < nackWait )
+            continue;
+        if ( !list.lastNack.is_not_a_date_time() &&
+                ( now - list.lastNack ).total_milliseconds() < retryInterval )
+            continue;
+
+        FragmentNack nack;
+        nack.frameId = it->first;
+        nack.packetTimestamp = list.packetTimestamp;
+        list.getMissing ( nack.fragments, NackPacket::maxFragments,
+                          sending ? list.getReceivedEnd() :
+                          FragmentList::maxFragments );
+        if ( nack.fragments.empty() )
+            continue;
+        list.lastNack = now;
+        nacks.push_back ( nack );
+    }
 }
 
 bool FragmentManager::hasCompleteFrame() const
 {
-    return fragmentList.isComplete();
+    return !completeFrames.empty();
+}
+
+void FragmentManager::getCompleteFrame ( Frame& frame )
+{
+    frame = std::move ( completeFrames.front() );
+    completeFrames.pop_front();
+}
+
+FrameBufferPool& FragmentManager::getPool()
+{
+    return pool;
 }
 
-Frame* FragmentManager::getCompleteFrame( ) const
+FragmentStats FragmentManager::getStats() const
 {
-    return new Frame ( fragmentList.getData(),
-	boost::posix_time::microsec_clock::local_time(),
-	fragmentList.packetTimestamp
- 		    );
+    FragmentStats stats;
+    stats.completed = completed;
+    stats.late = late;
+    stats.abandoned = abandoned;
+    stats.missing = missing;
+    stats.recovered = recovered;
+    return stats;
 }
 
-std::vector< FragmentPacket > FragmentManager::cut ( char* data,
-        unsigned int size )
+/**
+ * @brief Cut a frame into fragments
+ *
+ * Fragments are views into the shared frame buffer, so no payload byte is
+ * copied here. Parity fragments, if any, follow the data fragments.
+ */
+std::vector< FragmentPacket > FragmentManager::cut (
+    const std::shared_ptr<const byte_str>& frame, unsigned int frameId,
+    unsigned int fragmentSize, unsigned int repairCount )
 {
-    unsigned int nbOfPackets = size / 1500 + ( size % 1500 == 0 ? 0 : 1 );
+    const unsigned int size = frame->size();
+    unsigned int nbOfPackets = ( size + fragmentSize - 1 ) / fragmentSize;
+    repairCount = std::min ( repairCount, std::min ( nbOfPackets, 255u ) );
     std::vector<FragmentPacket> res;
+    res.reserve ( nbOfPackets + repairCount );
 
-    byte_str data_str ( reinterpret_cast<unsigned char*> ( data ), size );
     boost::posix_time::ptime time =
         boost::posix_time::microsec_clock::local_time();
 
     for ( unsigned int i = 0; i < nbOfPackets; i++ ) {
-        byte_str fragmentData;
+        const unsigned int offset = fragmentSize * i;
+        res.push_back ( FragmentPacket ( frame, offset,
+                                         std::min ( fragmentSize, size - offset ),
+                                         time, frameId, i, nbOfPackets,
+                                         SockAddress() ) );
+        res.back().fragmentSize = fragmentSize;
+        res.back().repairCount = repairCount;
+    }
 
-        try {
-            fragmentData = data_str.substr ( 1500 * i, 1500 );
-        } catch ( std::out_of_range& e ) {
-            std::cout << e.what() << std::endl;
+    for ( unsigned int j = 0; j < repairCount; j++ ) {
+        // The first fragment of a group is the longest
+        byte_str parity ( std::min ( fragmentSize, size - fragmentSize * j ), 0 );
+        for ( unsigned int i = j; i < nbOfPackets; i += repairCount ) {
+            const byte* p = frame->data() + fragmentSize * i;
+            const unsigned int length = std::min ( fragmentSize,
+                                                   size - fragmentSize * i );
+            for ( unsigned int k = 0; k < length; k++ )
+                parity[k] ^= p[k];
         }
-
-        res.insert ( res.end(), FragmentPacket ( fragmentData,
-                     time, i, size,
-                     SockAddress() ) );
+        res.push_back ( FragmentPacket ( parity, time, frameId,
+                                         nbOfPackets + j, nbOfPackets, size,
+                                         SockAddress() ) );
+        res.back().fragmentSize = fragmentSize;
+        res.back().repairCount = repairCount;
     }
 
     return res;
@@ -21,20 +21,137 @@
 #include "frame.h"
 #include "packets/fragmentpacket.h"
 #include "fragmentlist.h"
+#include "framebufferpool.h"
 #include <parser/gttparser.h>
 #include <list>
+#include <map>
+#include <deque>
+#include <atomic>
 
+/**
+ * @brief Reassembly counters of a FragmentManager
+ */
+struct FragmentStats {
+    /** Frames fully reassembled */
+    unsigned long completed;
+    /** Frames completed after a more recent frame */
+    unsigned long late;
+    /** Incomplete frames evicted from the reassembly window */
+    unsigned long abandoned;
+    /** Frames skipped by the frame ids of which no fragment arrived */
+    unsigned long missing;
+    /** Frames completed thanks to parity fragments */
+    unsigned long recovered;
+};
+
+/**
+ * @brief Fragments of an incomplete frame to ask again
+ */
+struct FragmentNack {
+    unsigned int frameId;
+    /** Time the peer sent the frame */
+    boost::posix_time::ptime packetTimestamp;
+    std::vector<unsigned short> fragments;
+};
+
+/**
+ * @brief Reassemble the frames of one peer
+ *
+ * Several frames may be in flight at once, so that fragments reordered
+ * across frame boundaries do not discard nearly complete frames. The
+ * window is bounded in number of frames, memory and age.
+ *
+ * VP8 frames refer to the previous ones, so they are given in frame id
+ * order: a frame completed before an older one is held until the older
+ * frame completes or is given up. Held frames count in the window, so
+ * that a lost frame is given up after maxFrames newer frames at most.
+ * JPEG frames are given as they complete.
+ */
 class FragmentManager {
     typedef boost::posix_time::ptime ptime;
 public:
     FragmentManager();
     void eat ( FragmentPacket& fp );
     bool hasCompleteFrame() const;
-    Frame* getCompleteFrame() const;
-    static std::vector<FragmentPacket> cut ( char* data, unsigned int size );
+    /**
+     * @brief Pop the oldest completed frame into the given one
+     */
+    void getCompleteFrame ( Frame& frame );
+    FragmentStats getStats() const;
+    /**
+     * @brief Get the incomplete frames whose missing fragments are lost
+     *
+     * The sender paces the fragments of a frame over the frame interval, so
+     * the fragments of the newest frame after the highest one received may
+     * not be sent yet. Only the gaps below it are considered lost, once the
+     * frame waited nackWait for reordered fragments. The other frames have
+     * lost all their missing fragments, as a newer frame arrived. A frame is
+     * given again only after retryInterval, so that the retransmission has
+     * time to arrive.
+     * @param retryInterval minimum time between two NACKs of a frame, in ms
+     */
+    void getNacks ( const ptime& now, unsigned int retryInterval,
+                    std::vector<FragmentNack>& nacks );
+    /**
+     * @brief Pool the buffers of decoded frames must be given back to
+     */
+    FrameBufferPool& getPool();
+    /**
+     * @param fragmentSize payload size of the fragments
+     * @param repairCount number of parity fragments added to the frame
+     */
+    static std::vector<FragmentPacket> cut (
+        const std::shared_ptr<const byte_str>& frame, unsigned int frameId,
+        unsigned int fragmentSize, unsigned int repairCount = 0 );
+
+    /**
+     * @brief Maximum number of frames being reassembled at once
+     */
+    static const unsigned int maxFrames = 8;
+    /**
+     * @brief Maximum number of bytes held by frames being reassembled
+     */
+    static const unsigned int maxBytes = 4 * 1024 * 1024;
+    /**
+     * @brief Maximum time an incomplete frame is waited for, in ms
+     */
+    static const unsigned int maxAge = 1000;
+    /**
+     * @brief Time an incomplete frame waits for reordered fragments before
+     *        they are considered lost, in ms
+     */
+    static const unsigned int nackWait = 20;
 
 private:
-    FragmentList fragmentList;
+    void expect ( unsigned int frameId, const ptime& now );
+    void evict ( const ptime& now );
+    void abandon ( std::map<unsigned int, FragmentList>::iterator it );
+    void finish ( unsigned int frameId );
+    void release();
+
+    std::map<unsigned int, FragmentList> fragmentLists;
+    unsigned int bytes;
+    FrameBufferPool pool;
+    std::deque<Frame> completeFrames;
+    // Completed VP8 frames waiting for an older frame
+    std::map<unsigned int, Frame> held;
+
+    // Most recent completed frame, and frames which must not be rebuilt
+    bool hasLastComplete;
+    unsigned int lastComplete;
+    std::deque<unsigned int> finished;
+
+    // Highest frame id started, and skipped ids still waited for with the
+    // time the gap was seen
+    bool hasNewest;
+    unsigned int newest;
+    std::map<unsigned int, ptime> expected;
+
+    std::atomic<unsigned long> completed;
+    std::atomic<unsigned long> late;
+    std::atomic<unsigned long> abandoned;
+    std::atomic<unsigned long> missing;
+    std::atomic<unsigned long> recovered;
 };
 
 #endif // FRAGMENTMANAGER_H
@@ -21,17 +21,106 @@
 #include <QBuffer>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
-Frame::Frame ( const Epyx::byte_str& data, const Frame::ptime& timestamp,
+Frame::Frame()
+{
+}
+
+Frame::Frame ( Epyx::byte_str& data, const Frame::ptime& timestamp,
 	       const ptime& rt):
     timestamp(timestamp),
     realTime(rt)
 {
-    QByteArray message = QByteArray(
+    this->data.swap ( data );
+}
+
+void Frame::decode ( const QSize& maxSize )
+{
+    // The reader works directly on the reassembly buffer
+    QByteArray message = QByteArray::fromRawData(
                              reinterpret_cast<const char * > ( data.data() ),
                              data.size());
     QBuffer buffer ( &message );
     QImageReader in ( &buffer, "JPG" );
-    image = in.read().copy();
+
+    // The JPEG decoder skips the detail a smaller image cannot show
+    const QSize size = in.size();
+    if ( maxSize.isValid() && size.isValid() &&
+            ( size.width() > maxSize.width() ||
+              size.height() > maxSize.height() ) )
+        in.setScaledSize ( size.scaled ( maxSize, Qt::KeepAspectRatio ) );
+
+    image = in.read();
+}
+
+/**
+ * @brief Convert a YUV 4:2:0 image to RGB, skipping pixels to fit maxSize
+ */
+static QImage toQImage ( const vpx_image_t* img, const QSize& maxSize )
+{
+    unsigned int step = 1;
+    while ( maxSize.isValid() &&
+            ( img->d_w / step > ( unsigned int ) maxSize.width() ||
+              img->d_h / step > ( unsigned int ) maxSize.height() ) )
+        step++;
+
+    QImage image ( img->d_w / step, img->d_h / step, QImage::Format_RGB32 );
+    for ( int y = 0; y < image.height(); y++ ) {
+        const unsigned int sy = y * step;
+        const unsigned char* lineY = img->planes[VPX_PLANE_Y] +
+                                     sy * img->stride[VPX_PLANE_Y];
+        const unsigned char* lineU = img->planes[VPX_PLANE_U] +
+                                     sy / 2 * img->stride[VPX_PLANE_U];
+        const unsigned char* lineV = img->planes[VPX_PLANE_V] +
+                                     sy / 2 * img->stride[VPX_PLANE_V];
+        QRgb* out = reinterpret_cast<QRgb*> ( image.scanLine ( y ) );
+        for ( int x = 0; x < image.width(); x++ ) {
+            const unsigned int sx = x * step;
+            // ITU-R BT.601, fixed point
+            const int c = lineY[sx] - 16;
+            const int d = lineU[sx / 2] - 128;
+            const int e = lineV[sx / 2] - 128;
+            const int r = ( 298 * c + 409 * e + 128 ) >> 8;
+            const int g = ( 298 * c - 100 * d - 208 * e + 128 ) >> 8;
+            const int b = ( 298 * c + 516 * d + 128 ) >> 8;
+            out[x] = qRgb ( qBound ( 0, r, 255 ), qBound ( 0, g, 255 ),
+                            qBound ( 0, b, 255 ) );
+        }
+    }
+    return image;
+}
+
+bool Frame::decode ( Epyx::webm::VpxDecoder& decoder, const QSize& maxSize,
+                     bool show )
+{
+    // The packet borrows the buffer for the time of the decoding
+    Epyx::webm::FramePacket packet ( data, 0, 0 );
+    const bool decoded = decoder.decode ( packet );
+    data.swap ( packet.data );
+    if ( !decoded || !show )
+        return decoded;
+
+    const vpx_image_t* img = decoder.getFrame();
+    if ( img != NULL )
+        image = toQImage ( img, maxSize );
+    return true;
+}
+
+bool Frame::isJpeg() const
+{
+    // VP8 frame tags never start with 0xFF, which is an invalid version
+    return data.size() >= 2 && data[0] == 0xFF && data[1] == 0xD8;
+}
+
+bool Frame::isKeyframe() const
+{
+    // The lowest bit of the VP8 frame tag is set on inter frames
+    return !data.empty() && !isJpeg() && ( data[0] & 1 ) == 0;
+}
+
+void Frame::takeData ( Epyx::byte_str& buffer )
+{
+    buffer.swap ( data );
+    data.clear();
 }
 
 bool Frame::operator< ( const Frame& B ) const
@@ -49,9 +138,12 @@ Frame::ptime Frame::getTime() const
     return timestamp;
 }
 
-void Frame::setDelay ( unsigned int delay )
+void Frame::setTime ( const Frame::ptime& time )
+{
+    timestamp = time;
+}
+
+Frame::ptime Frame::getRealTime() const
 {
-    //std::cout << delay << ":" << (realTime - timestamp) << "   ";
-    timestamp = timestamp - boost::posix_time::milliseconds(delay);
-    //std::cout << (realTime - timestamp) << std::endl;
+    return realTime;
 }
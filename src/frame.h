@@ -20,29 +20,68 @@
 
 #include <QImage>
 #include <core/common.h>
+#include <webm/vpxdecoder.h>
 #include <boost/date_time/posix_time/ptime.hpp>
-#include <functional>
 
 class Frame {
     typedef boost::posix_time::ptime ptime;
 public:
-    Frame ( const Epyx::byte_str& data, const ptime& timestamp,
+    /**
+     * @brief Build an empty frame, to be assigned later
+     */
+    Frame();
+    /**
+     * @brief Build a frame from its compressed data, which is SWAPPED in
+     *
+     * The frame is not decoded yet, see decode().
+     */
+    Frame ( Epyx::byte_str& data, const ptime& timestamp,
             const ptime& realTime );
     bool operator< ( const Frame& B ) const;
+    /**
+     * @brief Decode the compressed data into the image
+     * @param maxSize size the image is shrunk to fit in while it is decoded,
+     *        or an invalid size to keep the full resolution
+     */
+    void decode ( const QSize& maxSize = QSize() );
+    /**
+     * @brief Decode a VP8 frame
+     *
+     * Frames must be given to the decoder in order since they refer to the
+     * previous ones.
+     *
+     * @param decoder decoder of the peer
+     * @param maxSize size the image is shrunk to fit in
+     * @param show false to only update the decoder, leaving the image null
+     * @return false if the decoder rejected the frame
+     */
+    bool decode ( Epyx::webm::VpxDecoder& decoder, const QSize& maxSize,
+                  bool show );
+    /**
+     * @brief Whether the data is a JPEG picture rather than a VP8 frame
+     */
+    bool isJpeg() const;
+    /**
+     * @brief Whether the data is a VP8 keyframe, which refers to no other
+     */
+    bool isKeyframe() const;
+    /**
+     * @brief Move the compressed data out of this frame
+     */
+    void takeData ( Epyx::byte_str& buffer );
     QImage getImage() const;
     ptime getTime() const;
-    void setDelay ( unsigned int delay );
+    void setTime ( const ptime& time );
+    /**
+     * @brief Time the peer sent the frame, on its own clock
+     */
+    ptime getRealTime() const;
 
 private:
+    Epyx::byte_str data;
     QImage image;
     ptime timestamp;
     ptime realTime;
 };
 
-struct FrameCompare : public std::binary_function<Frame*, Frame*, bool> {
-    bool operator() ( const Frame* a, const Frame* b ) {
-        return ! ( *a < *b );
-    }
-};
-
 #endif // FRAME_H
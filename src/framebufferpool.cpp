@@ -0,0 +1,47 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+#include "framebufferpool.h"
+
+FrameBufferPool::FrameBufferPool ( unsigned int maxBuffers ) :
+    maxBuffers ( maxBuffers )
+{
+}
+
+byte_str FrameBufferPool::acquire ( unsigned int size )
+{
+    byte_str buffer;
+    {
+        std::lock_guard<std::mutex> lock ( mutex );
+        if ( !buffers.empty() ) {
+            buffer.swap ( buffers.back() );
+            buffers.pop_back();
+        }
+    }
+    // No reallocation as long as the recycled capacity is large enough
+    buffer.resize ( size );
+    return buffer;
+}
+
+void FrameBufferPool::release ( byte_str& buffer )
+{
+    std::lock_guard<std::mutex> lock ( mutex );
+    if ( buffers.size() < maxBuffers ) {
+        buffers.push_back ( byte_str() );
+        buffers.back().swap ( buffer );
+    }
+}
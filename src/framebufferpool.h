@@ -0,0 +1,56 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+#ifndef FRAMEBUFFERPOOL_H
+#define FRAMEBUFFERPOOL_H
+
+#include "core/byte.h"
+#include <vector>
+#include <mutex>
+
+using namespace Epyx;
+
+/**
+ * @brief Recycle the buffers frames are reassembled in
+ *
+ * Frames of a peer have similar sizes, so reusing the buffers of previous
+ * frames avoids allocating and clearing a new one for each frame.
+ */
+class FrameBufferPool {
+public:
+    /**
+     * @param maxBuffers maximum number of idle buffers kept
+     */
+    FrameBufferPool ( unsigned int maxBuffers = 8 );
+
+    /**
+     * @brief Get a buffer of the given size, with unspecified content
+     */
+    byte_str acquire ( unsigned int size );
+
+    /**
+     * @brief Give a buffer back, its content is swapped out
+     */
+    void release ( byte_str& buffer );
+
+private:
+    unsigned int maxBuffers;
+    std::vector<byte_str> buffers;
+    std::mutex mutex;
+};
+
+#endif // FRAMEBUFFERPOOL_H
@@ -0,0 +1,86 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+
+#include "frameclock.h"
+#include <errno.h>
+#include <time.h>
+
+FrameClock::FrameClock ( unsigned long interval ) :
+    interval ( interval ), startTime ( 0 ), next ( 0 ), frames ( 0 ),
+    skipped ( 0 ), totalJitter ( 0 ), maxJitter ( 0 )
+{
+}
+
+long long FrameClock::now()
+{
+    struct timespec ts;
+    clock_gettime ( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+void FrameClock::sleepUntil ( long long time )
+{
+    struct timespec ts;
+    ts.tv_sec = time / 1000000;
+    ts.tv_nsec = ( time % 1000000 ) * 1000;
+    while ( clock_nanosleep ( CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL )
+            == EINTR );
+}
+
+void FrameClock::start()
+{
+    next = now();
+    startTime = next;
+}
+
+unsigned int FrameClock::wait()
+{
+    next += interval;
+
+    // Behind by whole frames: drop them instead of catching up
+    unsigned int missed = 0;
+    const long long late = now() - next;
+    if ( late >= interval ) {
+        missed = late / interval;
+        next += missed * interval;
+    }
+
+    sleepUntil ( next );
+
+    const long long delay = now() - next;
+    const unsigned long jitter = delay > 0 ? delay : 0;
+    frames++;
+    skipped += missed;
+    totalJitter += jitter;
+    unsigned long longest = maxJitter;
+    while ( jitter > longest &&
+            !maxJitter.compare_exchange_weak ( longest, jitter ) );
+    return missed;
+}
+
+FrameClockStats FrameClock::getStats() const
+{
+    FrameClockStats stats;
+    stats.frames = frames;
+    stats.skipped = skipped;
+    const long long elapsed = now() - startTime;
+    stats.fps = elapsed > 0 ? stats.frames * 1000000.0 / elapsed : 0;
+    stats.jitter = stats.frames ? totalJitter / stats.frames : 0;
+    stats.maxJitter = maxJitter;
+    return stats;
+}
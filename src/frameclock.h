@@ -0,0 +1,85 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+
+#ifndef FRAMECLOCK_H
+#define FRAMECLOCK_H
+
+#include <atomic>
+
+/**
+ * @brief Frame clock statistics
+ */
+struct FrameClockStats {
+    /** Number of frame times reached */
+    unsigned long frames;
+    /** Number of frame times skipped because the sender was behind */
+    unsigned long skipped;
+    /** Frames per second actually reached since the clock started */
+    double fps;
+    /** Average delay of the frame times on their schedule, in microseconds */
+    unsigned long jitter;
+    /** Longest delay of a frame time on its schedule, in microseconds */
+    unsigned long maxJitter;
+};
+
+/**
+ * @brief Tick at a fixed frame rate on an absolute monotonic timeline
+ *
+ * Frame times are start + n * interval, whatever the time spent working
+ * between two ticks, so the frame rate does not drift with the load. When
+ * the work takes longer than an interval, the missed frame times are
+ * skipped rather than accumulated as lag.
+ *
+ * Must be used by a single thread, except for getStats().
+ */
+class FrameClock {
+public:
+    /**
+     * @param interval time between two frames, in microseconds
+     */
+    FrameClock ( unsigned long interval );
+
+    /**
+     * @brief Start the timeline now
+     */
+    void start();
+
+    /**
+     * @brief Sleep until the next frame time
+     * @return number of frame times which were skipped
+     */
+    unsigned int wait();
+
+    FrameClockStats getStats() const;
+
+private:
+    static long long now();
+    static void sleepUntil ( long long time );
+
+    long long interval;
+    // Monotonic times, in microseconds
+    std::atomic<long long> startTime;
+    long long next;
+
+    std::atomic<unsigned long> frames;
+    std::atomic<unsigned long> skipped;
+    std::atomic<unsigned long> totalJitter;
+    std::atomic<unsigned long> maxJitter;
+};
+
+#endif // FRAMECLOCK_H
@@ -0,0 +1,56 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+#include "framering.h"
+
+FrameRing::FrameRing() :
+    slots ( capacity ), head ( 0 ), tail ( 0 )
+{
+}
+
+FrameRing::PushResult FrameRing::push ( Frame& frame )
+{
+    if ( !lastSent.is_not_a_date_time() && frame.getRealTime() < lastSent )
+        return late;
+
+    const unsigned int t = tail.load ( std::memory_order_relaxed );
+    if ( t - head.load ( std::memory_order_acquire ) == capacity )
+        return full;
+
+    if ( !lastTime.is_not_a_date_time() && frame.getTime() < lastTime )
+        frame.setTime ( lastTime );
+    lastTime = frame.getTime();
+    lastSent = frame.getRealTime();
+
+    slots[t % capacity] = std::move ( frame );
+    tail.store ( t + 1, std::memory_order_release );
+    return pushed;
+}
+
+Frame* FrameRing::front()
+{
+    const unsigned int h = head.load ( std::memory_order_relaxed );
+    if ( h == tail.load ( std::memory_order_acquire ) )
+        return NULL;
+    return &slots[h % capacity];
+}
+
+void FrameRing::pop()
+{
+    const unsigned int h = head.load ( std::memory_order_relaxed );
+    head.store ( h + 1, std::memory_order_release );
+}
@@ -0,0 +1,87 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+#ifndef FRAMERING_H
+#define FRAMERING_H
+
+#include "frame.h"
+#include <vector>
+#include <atomic>
+
+/**
+ * @brief Bounded queue of the frames of one peer, in playout order
+ *
+ * There must be exactly one producer thread, calling push(), and one
+ * consumer thread, calling front() and pop(). Neither of them ever blocks.
+ * Slots are allocated once and reused for every frame.
+ */
+class FrameRing {
+    typedef boost::posix_time::ptime ptime;
+public:
+    FrameRing();
+
+    /**
+     * @brief Outcome of push()
+     */
+    enum PushResult {
+        /** The frame was moved into the ring */
+        pushed,
+        /** The ring is full */
+        full,
+        /** The frame was sent before the last pushed one */
+        late
+    };
+
+    /**
+     * @brief Move a frame into the ring (producer side)
+     *
+     * A frame sent before the last pushed one would be played after a
+     * newer frame, so it is refused. A newer frame due before the last one
+     * is postponed to keep the ring in playout order.
+     *
+     * @return whether the frame was pushed, it is left untouched otherwise
+     */
+    PushResult push ( Frame& frame );
+
+    /**
+     * @brief Get the oldest frame (consumer side)
+     * @return the frame, or NULL if the ring is empty
+     */
+    Frame* front();
+
+    /**
+     * @brief Release the slot of the oldest frame (consumer side)
+     */
+    void pop();
+
+    /**
+     * @brief Number of frames in the ring, a power of two
+     */
+    static const unsigned int capacity = 64;
+
+private:
+    std::vector<Frame> slots;
+    // Next slot to read, written by the consumer only
+    std::atomic<unsigned int> head;
+    // Next slot to write, written by the producer only
+    std::atomic<unsigned int> tail;
+    // Playout and sending times of the last pushed frame, producer only
+    ptime lastTime;
+    ptime lastSent;
+};
+
+#endif // FRAMERING_H
@@ -0,0 +1,122 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+#include "framesource.h"
+#include "core/log.h"
+
+FrameSource::~FrameSource()
+{
+}
+
+FrameSource* FrameSource::create ( const std::string& name,
+                                   unsigned int width, unsigned int height )
+{
+    if ( name == "synthetic" )
+        return new SyntheticSource();
+
+    if ( name == "camera" ) {
+        CameraSource* camera = new CameraSource ( width, height );
+        if ( camera->start() )
+            return camera;
+        delete camera;
+        return NULL;
+    }
+
+    RawFileSource* file = new RawFileSource ( name );
+    if ( file->isOpen() )
+        return file;
+    Epyx::log::error << "Unable to open raw video " << name
+                     << Epyx::log::endl;
+    delete file;
+    return NULL;
+}
+
+CameraSource::CameraSource ( unsigned int width, unsigned int height ) :
+    device ( width, height )
+{
+}
+
+bool CameraSource::start()
+{
+    return device.start_capture();
+}
+
+bool CameraSource::getFrame ( vpx_image_t* raw )
+{
+    return device.get_frame ( raw );
+}
+
+SyntheticSource::SyntheticSource() : count ( 0 )
+{
+}
+
+bool SyntheticSource::getFrame ( vpx_image_t* raw )
+{
+    // Diagonal bars scrolling by a few pixels per frame
+    for ( unsigned int y = 0; y < raw->d_h; y++ ) {
+        byte* line = raw->planes[VPX_PLANE_Y] + y * raw->stride[VPX_PLANE_Y];
+        for ( unsigned int x = 0; x < raw->d_w; x++ )
+            line[x] = ( ( x + y + 4 * count ) / 32 % 2 ) ? 200 : 50;
+    }
+    for ( unsigned int y = 0; y < ( raw->d_h + 1 ) / 2; y++ ) {
+        byte* u = raw->planes[VPX_PLANE_U] + y * raw->stride[VPX_PLANE_U];
+        byte* v = raw->planes[VPX_PLANE_V] + y * raw->stride[VPX_PLANE_V];
+        for ( unsigned int x = 0; x < ( raw->d_w + 1 ) / 2; x++ ) {
+            u[x] = 128 + ( count % 64 );
+            v[x] = 128 - ( count % 64 );
+        }
+    }
+    count++;
+    return true;
+}
+
+RawFileSource::RawFileSource ( const std::string& path ) :
+    file ( path.c_str(), std::ios::binary )
+{
+}
+
+bool RawFileSource::isOpen() const
+{
+    return file.is_open();
+}
+
+/**
+ * @brief Read one frame, starting over at the end of the file
+ */
+bool RawFileSource::getFrame ( vpx_image_t* raw )
+{
+    for ( int attempt = 0; attempt < 2; attempt++ ) {
+        bool complete = true;
+        for ( int plane = VPX_PLANE_Y; plane <= VPX_PLANE_V && complete;
+                plane++ ) {
+            const unsigned int w = plane == VPX_PLANE_Y ?
+                                   raw->d_w : ( raw->d_w + 1 ) / 2;
+            const unsigned int h = plane == VPX_PLANE_Y ?
+                                   raw->d_h : ( raw->d_h + 1 ) / 2;
+            for ( unsigned int y = 0; y < h && complete; y++ ) {
+                file.read ( reinterpret_cast<char*> ( raw->planes[plane] +
+                                                      y * raw->stride[plane] ), w );
+                complete = static_cast<unsigned int> ( file.gcount() ) == w;
+            }
+        }
+        if ( complete )
+            return true;
+        file.clear();
+        file.seekg ( 0, std::ios::beg );
+    }
+    return false;
+}
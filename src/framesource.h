@@ -0,0 +1,88 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+#ifndef FRAMESOURCE_H
+#define FRAMESOURCE_H
+
+#include "webm/videodev.h"
+#include <vpx/vpx_image.h>
+#include <fstream>
+#include <string>
+
+using namespace Epyx;
+
+/**
+ * @brief Raw YV12 frames to be encoded by the sender
+ */
+class FrameSource {
+public:
+    virtual ~FrameSource();
+    /**
+     * @brief Fill the next frame
+     * @param raw image allocated with the size of the source
+     * @return false if no frame is available
+     */
+    virtual bool getFrame ( vpx_image_t* raw ) = 0;
+
+    /**
+     * @brief Build the source named on the command line
+     * @param name "camera", "synthetic" or the path of a raw YV12 file
+     * @return the source, or NULL if it cannot be opened
+     */
+    static FrameSource* create ( const std::string& name, unsigned int width,
+                                 unsigned int height );
+};
+
+/**
+ * @brief Frames captured from /dev/video0
+ */
+class CameraSource : public FrameSource {
+public:
+    CameraSource ( unsigned int width, unsigned int height );
+    bool start();
+    bool getFrame ( vpx_image_t* raw );
+
+private:
+    webm::VideoDev device;
+};
+
+/**
+ * @brief Moving test pattern, for machines without a camera
+ */
+class SyntheticSource : public FrameSource {
+public:
+    SyntheticSource();
+    bool getFrame ( vpx_image_t* raw );
+
+private:
+    unsigned int count;
+};
+
+/**
+ * @brief Frames read in a loop from a file of raw YV12 frames
+ */
+class RawFileSource : public FrameSource {
+public:
+    RawFileSource ( const std::string& path );
+    bool isOpen() const;
+    bool getFrame ( vpx_image_t* raw );
+
+private:
+    std::ifstream file;
+};
+
+#endif // FRAMESOURCE_H
@@ -22,17 +22,19 @@
 #include <rttmanager.h>
 
 const int usersPerLine = 3;
-const int updateDelay = 1000 / 24;
+const unsigned int renderStatsInterval = 24 * 10;
 
 using namespace boost::posix_time;
 
 GUI::GUI ( VideoConferenceP2P* vc ) : conference ( vc ),
     layout ( new QGridLayout() ),
-    timer ( new QTimer )
+    timer ( new QTimer ),
+    schedulePending ( false )
 {
+    qRegisterMetaType<User*> ( "User*" );
     setLayout ( layout );
-    timer->setInterval ( updateDelay );
-    connect ( timer, SIGNAL ( timeout() ), this, SLOT ( update() ) );
+    timer->setSingleShot ( true );
+    connect ( timer, SIGNAL ( timeout() ), this, SLOT ( playout() ) );
 }
 
 void GUI::addUser ( User* u )
@@ -55,28 +57,78 @@ void GUI::addUser ( User* u )
 
 void GUI::start()
 {
-    timer->start();
+    schedule();
 }
 
-void GUI::update()
+void GUI::notifyFrame()
 {
-    ptime maxTime = microsec_clock::local_time();
-    maxTime = maxTime -
-              milliseconds ( RTTManager::threshold );
-    setWindowTitle ( QString::number (
-                         conference->getRTTManager()->getMaxDelay() ) );
+    // One pending event is enough to look at all the users
+    if ( !schedulePending.exchange ( true ) )
+        QMetaObject::invokeMethod ( this, "schedule", Qt::QueuedConnection );
+}
+
+void GUI::notifyDecoded ( User* u )
+{
+    QMetaObject::invokeMethod ( this, "display", Qt::QueuedConnection,
+                                Q_ARG ( User*, u ) );
+}
+
+/**
+ * @brief Arm the timer to the next playout time among all users
+ */
+void GUI::schedule()
+{
+    schedulePending = false;
 
+    ptime next;
     for ( auto it = videos.begin(); it != videos.end(); it++ ) {
-        QImage image = it.key()->getLatestFrame ( maxTime );
+        ptime time;
+        if ( it.key()->getNextPlayoutTime ( time ) &&
+                ( next.is_not_a_date_time() || time < next ) )
+            next = time;
+    }
+    if ( next.is_not_a_date_time() ) {
+        timer->stop();
+        return;
+    }
 
-        if ( !image.isNull() ) {
-            //std::cout << "Displaying new frame" << std::endl;
-            if ( it.key()->getDelay() > RTTManager::threshold )
-                it.value()->setDelayed ( true );
-            else
-                it.value()->setDelayed ( false );
+    const long long wait =
+        ( next - microsec_clock::local_time() ).total_microseconds();
+    timer->start ( wait > 0 ? ( wait + 999 ) / 1000 : 0 );
+}
 
-            it.value()->setImage ( image );
-        }
+/**
+ * @brief Hand the frames which are due to the decoders
+ */
+void GUI::playout()
+{
+    ptime now = microsec_clock::local_time();
+    for ( auto it = videos.begin(); it != videos.end(); it++ ) {
+        if ( isVisible() )
+            it.key()->setDisplaySize ( it.value()->viewport()->size() );
+        it.key()->playout ( now );
     }
+    schedule();
+}
+
+void GUI::display ( User* u )
+{
+    QImage image = u->takeDecodedImage();
+    auto it = videos.find ( u );
+    if ( image.isNull() || it == videos.end() )
+        return;
+
+    setWindowTitle ( QString::number (
+                         conference->getRTTManager()->getMaxDelay() ) );
+    //std::cout << "Displaying new frame" << std::endl;
+    if ( u->getDelay() > RTTManager::threshold )
+        it.value()->setDelayed ( true );
+    else
+        it.value()->setDelayed ( false );
+
+    it.value()->setImage ( image );
+    if ( it.value()->getRenderCount() % renderStatsInterval == 0 )
+        log::debug << "Rendering " << u->getName() << ": "
+                   << it.value()->getRenderTime() << " us per frame"
+                   << log::endl;
 }
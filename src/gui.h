@@ -24,6 +24,7 @@
 #include <QMap>
 #include <QTimer>
 #include "autoresizeimageview.h"
+#include <atomic>
 
 class VideoConferenceP2P;
 
@@ -35,15 +36,26 @@ public:
     GUI(VideoConferenceP2P* vc);
     void addUser( User* u);
     void start();
+    /**
+     * @brief Tell that a user has a new frame to play, from any thread
+     */
+    void notifyFrame();
+    /**
+     * @brief Tell that a frame of a user was decoded, from any thread
+     */
+    void notifyDecoded ( User* u );
     
 private slots:
-    void update();
+    void schedule();
+    void playout();
+    void display ( User* u );
 
 private:
     VideoConferenceP2P* conference;
     QGridLayout* layout;
     QMap<User*, AutoResizeImageView*> videos;
     QTimer* timer;
+    std::atomic<bool> schedulePending;
     int line = 0;
     int column = 0;
 };
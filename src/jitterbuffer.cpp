@@ -0,0 +1,87 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+#include "jitterbuffer.h"
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+JitterBuffer::JitterBuffer ( double lateRate ) :
+    lateRate ( lateRate ), next ( 0 ), hasPrevious ( false ),
+    previousTransit ( 0 ), jitter ( 0 ), fastest ( 0 ), delay ( 0 ),
+    jitterStat ( 0 ), delayStat ( 0 ), late ( 0 )
+{
+    transits.reserve ( window );
+}
+
+JitterBuffer::ptime JitterBuffer::playoutTime ( const ptime& arrival,
+        const ptime& sent )
+{
+    const long long transit = ( arrival - sent ).total_microseconds();
+
+    // RFC 3550, section 6.4.1
+    if ( hasPrevious )
+        jitter += ( std::abs ( transit - previousTransit ) - jitter ) / 16;
+    previousTransit = transit;
+    hasPrevious = true;
+
+    if ( transits.size() < window )
+        transits.push_back ( transit );
+    else
+        transits[next] = transit;
+    next = ( next + 1 ) % window;
+
+    // Delay above the fastest transit which plays enough frames on time
+    std::vector<long long> sorted ( transits );
+    fastest = *std::min_element ( sorted.begin(), sorted.end() );
+    const unsigned int rank = std::min<unsigned int> ( sorted.size() - 1,
+                              std::ceil ( sorted.size() * ( 1 - lateRate ) ) );
+    std::nth_element ( sorted.begin(), sorted.begin() + rank, sorted.end() );
+    const long long target = sorted[rank] - fastest + margin * 1000;
+
+    if ( transit - fastest > delay )
+        late++;
+
+    // Grow at once on a spike, shrink slowly once it is over
+    if ( target > delay )
+        delay = target;
+    else
+        delay += ( target - delay ) / 16;
+
+    jitterStat = jitter;
+    delayStat = delay / 1000;
+
+    return sent + boost::posix_time::microseconds ( fastest + delay );
+}
+
+bool JitterBuffer::deadline ( const ptime& sent, ptime& time ) const
+{
+    if ( !hasPrevious )
+        return false;
+    time = sent + boost::posix_time::microseconds ( fastest + delay );
+    return true;
+}
+
+JitterStats JitterBuffer::getStats() const
+{
+    JitterStats stats;
+    stats.jitter = jitterStat;
+    stats.delay = delayStat;
+    stats.late = late;
+    return stats;
+}
@@ -0,0 +1,101 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+#ifndef JITTERBUFFER_H
+#define JITTERBUFFER_H
+
+#include <boost/date_time/posix_time/ptime.hpp>
+#include <vector>
+#include <atomic>
+
+/**
+ * @brief Playout statistics of a JitterBuffer
+ */
+struct JitterStats {
+    /** Interarrival jitter as defined by RFC 3550, in microseconds */
+    unsigned int jitter;
+    /** Current playout delay on top of the fastest transit, in ms */
+    unsigned int delay;
+    /** Frames which arrived after their playout time */
+    unsigned long late;
+};
+
+/**
+ * @brief Schedule the playout of the frames of one peer
+ *
+ * The transit time of a frame is its arrival time minus the time the peer
+ * sent it. Clocks are not synchronized, so only the spread of the transit
+ * times is meaningful: the fastest recent transit is the reference, and the
+ * playout delay is the smallest delay above it which would have played the
+ * given share of the recent frames on time.
+ *
+ * Must be used by a single thread, except for getStats().
+ */
+class JitterBuffer {
+    typedef boost::posix_time::ptime ptime;
+public:
+    /**
+     * @param lateRate share of the frames allowed to miss their playout time
+     */
+    JitterBuffer ( double lateRate = 0.01 );
+
+    /**
+     * @brief Account for a new frame and get when to play it
+     * @param arrival local time the frame was completed
+     * @param sent peer time the frame was sent
+     * @return playout time, on the local clock
+     */
+    ptime playoutTime ( const ptime& arrival, const ptime& sent );
+
+    /**
+     * @brief Get when a frame will be played, without accounting for it
+     * @param sent peer time the frame was sent
+     * @param time set to the playout time, on the local clock
+     * @return false if no frame arrived yet to estimate it
+     */
+    bool deadline ( const ptime& sent, ptime& time ) const;
+
+    JitterStats getStats() const;
+
+    /**
+     * @brief Number of frames the delay is estimated on
+     */
+    static const unsigned int window = 128;
+    /**
+     * @brief Delay added for the decoding and display refresh, in ms
+     */
+    static const unsigned int margin = 10;
+
+private:
+    double lateRate;
+
+    // Transit times of the last frames, in microseconds
+    std::vector<long long> transits;
+    unsigned int next;
+
+    bool hasPrevious;
+    long long previousTransit;
+    double jitter;
+    long long fastest;
+    long long delay;
+
+    std::atomic<unsigned int> jitterStat;
+    std::atomic<unsigned int> delayStat;
+    std::atomic<unsigned long> late;
+};
+
+#endif // JITTERBUFFER_H
@@ -21,6 +21,7 @@
 #include "boost/lexical_cast.hpp"
 #include <QApplication>
 #include "boost/algorithm/string.hpp"
+#include <algorithm>
 
 /**
  * @brief ...
@@ -32,11 +33,23 @@ int main ( int argc, char*argv[] )
 {
     QApplication app ( argc, argv );
 
-    if ( argc != 3 && argc != 4) {
-        std::cout << "Use : videoconferencep2p n k [display=true]" << std::endl;
+    if ( argc < 3 || argc > 9 ) {
+        std::cout << "Use : videoconferencep2p n k [display=true] [wire=binary]"
+                  " [decoders] [source=jpeg] [mtu=1500] [burst=12000]"
+                  << std::endl;
         std::cout << "n is the total number of clients "
                   "and k the number of the current client."
                   "The first client is number 0" << std::endl;
+        std::cout << "wire is binary or gtt, the text format being meant "
+                  "for debugging" << std::endl;
+        std::cout << "decoders is the number of threads decoding the "
+                  "received frames" << std::endl;
+        std::cout << "source is jpeg to replay the frames directory, or camera,"
+                  " synthetic or a raw YV12 file to send VP8" << std::endl;
+        std::cout << "mtu is the MTU of the paths to the other clients, "
+                  "no datagram is sent larger than it" << std::endl;
+        std::cout << "burst is the number of bytes of video sent "
+                  "back-to-back, before pacing" << std::endl;
         return EXIT_FAILURE;
     }
 
@@ -59,13 +72,26 @@ int main ( int argc, char*argv[] )
         }
     }
 
-    if ( argc == 4 ) {
+    if ( argc >= 4 ) {
         string display = argv[3];
         if ( boost::iequals ( display, "true" ) )
             vc.display ( false );
     }
+    if ( argc >= 5 ) {
+        string wire = argv[4];
+        vc.setBinaryWire ( !boost::iequals ( wire, "gtt" ) );
+    }
+    if ( argc >= 6 )
+        vc.setDecodeWorkers ( std::max ( 1, std::atoi ( argv[5] ) ) );
+    if ( argc >= 7 )
+        vc.setVideoSource ( argv[6] );
+    if ( argc >= 8 )
+        vc.setMtu ( std::atoi ( argv[7] ) );
+    if ( argc >= 9 )
+        vc.setPacingBurst ( std::max ( 1, std::atoi ( argv[8] ) ) );
     vc.start();
     app.exec();
+    vc.stop();
     Epyx::log::debug << "Program ended"  <<  Epyx::log::endl;
     Epyx::log::flushAndQuit();
 }
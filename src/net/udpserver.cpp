@@ -28,11 +28,20 @@ namespace Epyx
     }
 
 
+    int UDPServer::recvBatch(UDPRecvBatch& batch) {
+        return sock.recvBatch(batch);
+    }
+
     int UDPServer::sendTo(SockAddress address, const void *data, int size) {
 	QMutexLocker locker (&mutex_sendTo);
         return sock.sendTo(address, data, size);
     }
 
+    int UDPServer::sendBatch(const std::vector<UDPDatagram>& batch) {
+	QMutexLocker locker (&mutex_sendTo);
+        return sock.sendBatch(batch);
+    }
+
 
     void UDPServer::bindToDevice(const std::string& devicename) {
         sock.bindToDevice(devicename);
@@ -54,6 +54,15 @@ namespace Epyx
          */
         int recv(void *data, int size);
 
+        /**
+         * @brief Receive as many datagrams as available, blocking for the
+         * first one
+         *
+         * @param batch buffers to fill
+         * @return number of received datagrams
+         */
+        int recvBatch(UDPRecvBatch& batch);
+
         /**
          * @brief Receive data for the server
          *
@@ -64,6 +73,14 @@ namespace Epyx
          */
         int sendTo(SockAddress address, const void *data, int size);
 
+        /**
+         * @brief Send several datagrams with as few system calls as possible
+         *
+         * @param batch datagrams to send, in order
+         * @return number of sent datagrams
+         */
+        int sendBatch(const std::vector<UDPDatagram>& batch);
+
         /**
          * @brief Bind socket to a specific device
          * @param devicename
@@ -1,9 +1,45 @@
 #include "udpsocket.h"
 #include "../core/common.h"
+#include <cstring>
+#include <algorithm>
 
 namespace Epyx
 {
 
+    UDPRecvBatch::UDPRecvBatch(unsigned int capacity, unsigned int datagramSize)
+    :capacity(capacity), datagramSize(datagramSize), received(0),
+    truncated(0), slots(capacity), buffers(capacity * datagramSize), iovs(capacity), msgs(capacity),
+    addrs(capacity) {
+        EPYX_ASSERT(capacity > 0 && datagramSize > 0);
+        for (unsigned int i = 0; i < capacity; i++) {
+            iovs[i].iov_base = &buffers[i * datagramSize];
+            iovs[i].iov_len = datagramSize;
+        }
+    }
+
+    unsigned int UDPRecvBatch::size() const {
+        return received;
+    }
+
+    const byte* UDPRecvBatch::data(unsigned int i) const {
+        EPYX_ASSERT(i < received);
+        return &buffers[slots[i] * datagramSize];
+    }
+
+    unsigned int UDPRecvBatch::length(unsigned int i) const {
+        EPYX_ASSERT(i < received);
+        return msgs[slots[i]].msg_len;
+    }
+
+    const struct sockaddr* UDPRecvBatch::address(unsigned int i) const {
+        EPYX_ASSERT(i < received);
+        return (const struct sockaddr *) &addrs[slots[i]];
+    }
+
+    unsigned long UDPRecvBatch::truncatedCount() const {
+        return truncated;
+    }
+
     UDPSocket::UDPSocket() {
     }
 
@@ -59,6 +95,48 @@ sizeof (saddr));
         return bytes;
     }
 
+    int UDPSocket::sendBatch(const std::vector<UDPDatagram>& batch) {
+        // sendmmsg does not accept more than UIO_MAXIOV messages at once
+        const size_t maxBatch = 1024;
+        size_t sent = 0;
+
+        // Create a new socket if it does not exist
+        if (sock < 0) {
+            this->create();
+        }
+
+        while (sent < batch.size()) {
+            const size_t count = std::min(batch.size() - sent, maxBatch);
+            batchMsgs.resize(count);
+            batchAddrs.resize(count);
+            for (size_t i = 0; i < count; i++) {
+                const UDPDatagram& dgram = batch[sent + i];
+                struct msghdr& msg = batchMsgs[i].msg_hdr;
+                EPYX_ASSERT(dgram.iovcnt <= UDPDatagram::maxIov);
+                dgram.address.getSockAddr((struct sockaddr *) &batchAddrs[i]);
+                memset(&batchMsgs[i], 0, sizeof (batchMsgs[i]));
+                msg.msg_name = &batchAddrs[i];
+                msg.msg_namelen = sizeof (batchAddrs[i]);
+                msg.msg_iov = const_cast<struct iovec *> (dgram.iov);
+                msg.msg_iovlen = dgram.iovcnt;
+            }
+
+            // sendmmsg may stop early, send the remaining messages again
+            size_t done = 0;
+            while (done < count) {
+                int r = ::sendmmsg(sock, &batchMsgs[done], count - done, 0);
+                if (r < 0)
+                    throw ErrException("UDPSocket", "sendmmsg");
+                done += r;
+            }
+            sent += count;
+        }
+
+        if (localAddress.empty())
+            this->updateLocalAddress();
+        return sent;
+    }
+
     int UDPSocket::send ( const void* data, int size ) {
 	sendTo(address, data, size);
     }
@@ -91,6 +169,31 @@ sizeof (saddr));
         return bytes;
     }
 
+    int UDPSocket::recvBatch(UDPRecvBatch& batch) {
+        EPYX_ASSERT(this->sock >= 0);
+        for (unsigned int i = 0; i < batch.capacity; i++) {
+            struct msghdr& msg = batch.msgs[i].msg_hdr;
+            memset(&batch.msgs[i], 0, sizeof (batch.msgs[i]));
+            msg.msg_name = &batch.addrs[i];
+            msg.msg_namelen = sizeof (batch.addrs[i]);
+            msg.msg_iov = &batch.iovs[i];
+            msg.msg_iovlen = 1;
+        }
+        batch.received = 0;
+        int r = ::recvmmsg(this->sock, &batch.msgs[0], batch.capacity,
+            MSG_WAITFORONE, NULL);
+        if (r < 0)
+            throw ErrException("UDPSocket", "recvmmsg");
+        // The end of a datagram larger than the buffer is lost
+        for (int i = 0; i < r; i++) {
+            if (batch.msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+                batch.truncated++;
+            else
+                batch.slots[batch.received++] = i;
+        }
+        return batch.received;
+    }
+
     SockAddress UDPSocket::getLastRecvAddr() const {
         return lastRecvAddr;
     }
@@ -21,11 +21,98 @@
 #define EPYX_UDPSOCKET_H
 
 #include "socket.h"
+#include "../core/byte.h"
+#include <boost/noncopyable.hpp>
+#include <sys/uio.h>
+#include <sys/socket.h>
+#include <vector>
 
 namespace Epyx
 {
     class UDPServer;
 
+    /**
+     * @struct UDPDatagram
+     * @brief A datagram to be sent in a batch
+     */
+    struct UDPDatagram
+    {
+        /**
+         * @brief Maximum number of buffers gathered into one datagram
+         */
+        static const int maxIov = 2;
+
+        /**
+         * @brief Destination address
+         */
+        SockAddress address;
+        /**
+         * @brief Buffers which are concatenated into the datagram
+         */
+        struct iovec iov[maxIov];
+        /**
+         * @brief Number of used buffers in iov
+         */
+        int iovcnt;
+    };
+
+    /**
+     * @class UDPRecvBatch
+     * @brief Preallocated buffers to receive several datagrams at once
+     *
+     * The same buffers are reused by every call to UDPSocket::recvBatch, so
+     * the received data is only valid until the next call.
+     */
+    class UDPRecvBatch : private boost::noncopyable
+    {
+    public:
+        /**
+         * @brief Allocate the buffers
+         * @param capacity maximum number of datagrams per call
+         * @param datagramSize maximum size of a datagram
+         */
+        UDPRecvBatch(unsigned int capacity, unsigned int datagramSize);
+
+        /**
+         * @brief Number of datagrams received by the last call
+         */
+        unsigned int size() const;
+        /**
+         * @brief Content of a received datagram
+         * @param i datagram index, lower than size()
+         */
+        const byte* data(unsigned int i) const;
+        /**
+         * @brief Size of a received datagram
+         * @param i datagram index, lower than size()
+         */
+        unsigned int length(unsigned int i) const;
+        /**
+         * @brief Address a datagram was received from
+         * @param i datagram index, lower than size()
+         */
+        const struct sockaddr* address(unsigned int i) const;
+        /**
+         * @brief Number of datagrams dropped so far because they were larger
+         * than datagramSize
+         */
+        unsigned long truncatedCount() const;
+
+    private:
+        friend class UDPSocket;
+
+        unsigned int capacity;
+        unsigned int datagramSize;
+        unsigned int received;
+        unsigned long truncated;
+        // Slots of the datagrams which were received whole
+        std::vector<unsigned int> slots;
+        std::vector<byte> buffers;
+        std::vector<struct iovec> iovs;
+        std::vector<struct mmsghdr> msgs;
+        std::vector<struct sockaddr_storage> addrs;
+    };
+
     /**
      * @class UDPSocket
      * @brief UDP socket abstraction layer
@@ -77,6 +164,14 @@ namespace Epyx
          */
         int sendTo(SockAddress address, const void *data, int size);
 
+        /**
+         * @brief Send several datagrams with as few system calls as possible
+         *
+         * @param batch datagrams to send, in order
+         * @return number of sent datagrams
+         */
+        int sendBatch(const std::vector<UDPDatagram>& batch);
+
         /**
          * @brief Receive data from the socket
          *
@@ -86,6 +181,16 @@ namespace Epyx
          */
         int recv(void *data, int size);
 
+        /**
+         * @brief Receive as many datagrams as available, blocking for the
+         * first one
+         *
+         * Truncated datagrams are dropped, so this may return 0.
+         * @param batch buffers to fill
+         * @return number of received datagrams
+         */
+        int recvBatch(UDPRecvBatch& batch);
+
         /**
          * @brief Get the remote address from which the last packet was received
          * @return remote address
@@ -100,6 +205,10 @@ namespace Epyx
 
     private:
         SockAddress lastRecvAddr;
+
+        // Scratch space for sendBatch, kept to avoid reallocations
+        std::vector<struct mmsghdr> batchMsgs;
+        std::vector<struct sockaddr_storage> batchAddrs;
     };
 
 }
@@ -0,0 +1,100 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+
+#include "pacer.h"
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <algorithm>
+#include <unistd.h>
+
+using namespace boost::posix_time;
+
+namespace
+{
+    size_t datagramSize ( const UDPDatagram& dgram )
+    {
+        size_t size = 0;
+        for ( int i = 0; i < dgram.iovcnt; i++ )
+            size += dgram.iov[i].iov_len;
+        return size;
+    }
+}
+
+Pacer::Pacer ( unsigned int burst ) :
+    burst ( burst ), tokens ( burst ),
+    lastRefill ( microsec_clock::local_time() ),
+    datagrams ( 0 ), totalDelay ( 0 ), maxDelay ( 0 )
+{
+}
+
+void Pacer::setBurst ( unsigned int burst )
+{
+    this->burst = burst;
+}
+
+void Pacer::refill ( const ptime& now, double rate, double capacity )
+{
+    tokens = std::min ( capacity, tokens + rate *
+                        ( now - lastRefill ).total_microseconds() / 1000000 );
+    lastRefill = now;
+}
+
+void Pacer::send ( UDPServer& server, const std::vector<UDPDatagram>& batch,
+                   double rate )
+{
+    const ptime start = microsec_clock::local_time();
+    size_t i = 0;
+
+    while ( i < batch.size() ) {
+        const ptime now = microsec_clock::local_time();
+        // A datagram larger than the bucket must still be able to leave
+        const double capacity = std::max<double> ( burst,
+                                datagramSize ( batch[i] ) );
+        refill ( now, rate, capacity );
+
+        chunk.clear();
+        while ( i < batch.size() && datagramSize ( batch[i] ) <= tokens ) {
+            tokens -= datagramSize ( batch[i] );
+            chunk.push_back ( batch[i++] );
+        }
+
+        if ( chunk.empty() ) {
+            // Wait for the tokens the next datagram lacks
+            const double missing = datagramSize ( batch[i] ) - tokens;
+            usleep ( std::max<long> ( 1, missing * 1000000 / rate ) );
+            continue;
+        }
+
+        server.sendBatch ( chunk );
+
+        const unsigned long delay = ( now - start ).total_microseconds();
+        datagrams += chunk.size();
+        totalDelay += delay * chunk.size();
+        unsigned long longest = maxDelay;
+        while ( delay > longest &&
+                !maxDelay.compare_exchange_weak ( longest, delay ) );
+    }
+}
+
+PacerStats Pacer::getStats() const
+{
+    PacerStats stats;
+    stats.datagrams = datagrams;
+    stats.averageDelay = stats.datagrams ? totalDelay / stats.datagrams : 0;
+    stats.maxDelay = maxDelay;
+    return stats;
+}
@@ -0,0 +1,89 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+
+#ifndef PACER_H
+#define PACER_H
+
+#include "net/udpserver.h"
+#include <boost/date_time/posix_time/ptime.hpp>
+#include <atomic>
+#include <vector>
+
+using namespace Epyx;
+
+/**
+ * @brief Pacing statistics
+ */
+struct PacerStats {
+    /** Number of datagrams sent */
+    unsigned long datagrams;
+    /** Average time datagrams waited for their turn, in microseconds */
+    unsigned long averageDelay;
+    /** Longest time a datagram waited for its turn, in microseconds */
+    unsigned long maxDelay;
+};
+
+/**
+ * @brief Spread batches of datagrams over time with a token bucket
+ *
+ * Sending a whole frame to every peer at once is a burst at line rate,
+ * which overflows shallow router queues and the socket buffers of the
+ * receivers. The bucket lets at most burst bytes leave at once and then
+ * refills at the given rate.
+ *
+ * Must be used by a single thread, except for getStats().
+ */
+class Pacer {
+    typedef boost::posix_time::ptime ptime;
+public:
+    /**
+     * @param burst size of the bucket, in bytes
+     */
+    Pacer ( unsigned int burst = defaultBurst );
+
+    void setBurst ( unsigned int burst );
+
+    /**
+     * @brief Send a batch of datagrams, sleeping whenever the bucket is empty
+     * @param rate pacing rate, in bytes per second
+     */
+    void send ( UDPServer& server, const std::vector<UDPDatagram>& batch,
+                double rate );
+
+    PacerStats getStats() const;
+
+    /**
+     * @brief Default bucket size, about 8 full datagrams
+     */
+    static const unsigned int defaultBurst = 12000;
+
+private:
+    void refill ( const ptime& now, double rate, double capacity );
+
+    std::atomic<unsigned int> burst;
+    double tokens;
+    ptime lastRefill;
+    // Datagrams which are sent together, kept to reuse its storage
+    std::vector<UDPDatagram> chunk;
+
+    std::atomic<unsigned long> datagrams;
+    std::atomic<unsigned long> totalDelay;
+    std::atomic<unsigned long> maxDelay;
+};
+
+#endif // PACER_H
@@ -18,25 +18,109 @@
 #include "fragmentpacket.h"
 
 #include "core/log.h"
+#include "core/assert.h"
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/date_time/posix_time/time_formatters.hpp>
 #include <boost/date_time/posix_time/time_parsers.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <netinet/in.h>
+#include <string.h>
+
+namespace
+{
+    const boost::posix_time::ptime epoch ( boost::gregorian::date ( 1970, 1, 1 ) );
+
+    // Size of the binary header of version 1, without the fragment size
+    const size_t binaryHeaderSizeV1 = 30;
+
+    void putU16 ( byte* p, unsigned short v )
+    {
+        p[0] = v >> 8;
+        p[1] = v;
+    }
+
+    void putU32 ( byte* p, uint32_t v )
+    {
+        putU16 ( p, v >> 16 );
+        putU16 ( p + 2, v );
+    }
+
+    void putU64 ( byte* p, uint64_t v )
+    {
+        putU32 ( p, v >> 32 );
+        putU32 ( p + 4, v );
+    }
+
+    unsigned short getU16 ( const byte* p )
+    {
+        return ( p[0] << 8 ) | p[1];
+    }
+
+    uint32_t getU32 ( const byte* p )
+    {
+        return ( ( uint32_t ) getU16 ( p ) << 16 ) | getU16 ( p + 2 );
+    }
+
+    uint64_t getU64 ( const byte* p )
+    {
+        return ( ( uint64_t ) getU32 ( p ) << 32 ) | getU32 ( p + 4 );
+    }
+}
 
 FragmentPacket::FragmentPacket ( const byte_str& data,
                                  ptime packetTimestamp,
-                                 unsigned char fragmentNumber,
+                                 unsigned int frameId,
+                                 unsigned short fragmentNumber,
+                                 unsigned short fragmentCount,
                                  unsigned int packetSize,
                                  SockAddress source ) :
     data ( data ),
     source ( source ),
     packetTimestamp ( packetTimestamp ),
+    frameId ( frameId ),
     fragmentNumber ( fragmentNumber ),
-    packetSize ( packetSize )
+    fragmentCount ( fragmentCount ),
+    packetSize ( packetSize ),
+    fragmentSize ( defaultFragmentSize ),
+    repairCount ( 0 ),
+    view ( NULL ),
+    viewSize ( 0 )
 {
 }
 
-FragmentPacket::FragmentPacket ( const GTTPacket& gttpkt )
+FragmentPacket::FragmentPacket ( const std::shared_ptr<const byte_str>& frame,
+                                 size_t offset,
+                                 size_t length,
+                                 ptime packetTimestamp,
+                                 unsigned int frameId,
+                                 unsigned short fragmentNumber,
+                                 unsigned short fragmentCount,
+                                 SockAddress source ) :
+    source ( source ),
+    packetTimestamp ( packetTimestamp ),
+    frameId ( frameId ),
+    fragmentNumber ( fragmentNumber ),
+    fragmentCount ( fragmentCount ),
+    packetSize ( frame->size() ),
+    fragmentSize ( defaultFragmentSize ),
+    repairCount ( 0 ),
+    frame ( frame ),
+    view ( frame->data() + offset ),
+    viewSize ( length )
+{
+    EPYX_ASSERT ( offset + length <= frame->size() );
+}
+
+FragmentPacket::FragmentPacket ( const GTTPacket& gttpkt ) :
+    frameId ( 0 ),
+    fragmentNumber ( 0 ),
+    fragmentCount ( 0 ),
+    packetSize ( 0 ),
+    fragmentSize ( defaultFragmentSize ),
+    repairCount ( 0 ),
+    view ( NULL ),
+    viewSize ( 0 )
 {
     // Check protocol
     if ( gttpkt.protocol.compare ( "VCP2P" ) ) {
@@ -59,12 +143,24 @@ FragmentPacket::FragmentPacket ( const GTTPacket& gttpkt )
             packetTimestamp = boost::posix_time::time_from_string ( it->second
                                                                   );
 
+        if ( boost::iequals ( it->first, "Frame" ) )
+            frameId = boost::lexical_cast<unsigned int> ( it->second );
+
         if ( boost::iequals ( it->first, "Number" ) )
             fragmentNumber = boost::lexical_cast<long> ( it->second );
 
+        if ( boost::iequals ( it->first, "Count" ) )
+            fragmentCount = boost::lexical_cast<long> ( it->second );
+
         if ( boost::iequals ( it->first, "Size" ) )
             packetSize = boost::lexical_cast<long> ( it->second );
 
+        if ( boost::iequals ( it->first, "Repair" ) )
+            repairCount = boost::lexical_cast<unsigned int> ( it->second );
+
+        if ( boost::iequals ( it->first, "FragmentSize" ) )
+            fragmentSize = boost::lexical_cast<unsigned short> ( it->second );
+
         if ( boost::iequals ( it->first, "Source" ) )
             source = SockAddress ( it->second );
     }
@@ -73,6 +169,89 @@ FragmentPacket::FragmentPacket ( const GTTPacket& gttpkt )
     data = gttpkt.body;
 }
 
+FragmentPacket::FragmentPacket ( const GTTDatagram& dgram ) :
+    frameId ( 0 ),
+    fragmentNumber ( 0 ),
+    fragmentCount ( 0 ),
+    packetSize ( 0 ),
+    fragmentSize ( defaultFragmentSize ),
+    repairCount ( 0 ),
+    view ( dgram.body ),
+    viewSize ( dgram.bodySize )
+{
+    if ( !dgram.protocol.equals ( "VCP2P" ) ||
+            !dgram.method.equals ( "FRAGMENT" ) )
+        throw ParserException ( "FragmentPacket", "Invalid fragment packet" );
+
+    const GTTDatagram::Token* time = dgram.header ( "Time" );
+    const GTTDatagram::Token* frame = dgram.header ( "Frame" );
+    const GTTDatagram::Token* number = dgram.header ( "Number" );
+    const GTTDatagram::Token* count = dgram.header ( "Count" );
+    const GTTDatagram::Token* size = dgram.header ( "Size" );
+    const GTTDatagram::Token* from = dgram.header ( "Source" );
+    if ( !time || !frame || !number || !count || !size || !from )
+        throw ParserException ( "FragmentPacket", "Missing fragment header" );
+
+    packetTimestamp = boost::posix_time::time_from_string ( time->str() );
+    frameId = boost::lexical_cast<unsigned int> ( frame->data, frame->size );
+    fragmentNumber = boost::lexical_cast<unsigned short> ( number->data,
+                     number->size );
+    fragmentCount = boost::lexical_cast<unsigned short> ( count->data,
+                    count->size );
+    packetSize = boost::lexical_cast<unsigned int> ( size->data, size->size );
+    source = SockAddress ( from->str() );
+
+    const GTTDatagram::Token* repair = dgram.header ( "Repair" );
+    if ( repair )
+        repairCount = boost::lexical_cast<unsigned int> ( repair->data,
+                      repair->size );
+    const GTTDatagram::Token* fragment = dgram.header ( "FragmentSize" );
+    if ( fragment )
+        fragmentSize = boost::lexical_cast<unsigned short> ( fragment->data,
+                       fragment->size );
+}
+
+FragmentPacket::FragmentPacket ( const byte* datagram, size_t size ) :
+    fragmentSize ( defaultFragmentSize ),
+    repairCount ( 0 ),
+    view ( NULL ),
+    viewSize ( 0 )
+{
+    if ( !isBinary ( datagram, size ) )
+        throw ParserException ( "FragmentPacket", "Invalid binary fragment "
+                                "packet" );
+
+    size_t headerSize = binaryHeaderSize;
+    if ( datagram[2] == 1 )
+        headerSize = binaryHeaderSizeV1;
+    else if ( datagram[2] != binaryVersion )
+        throw ParserException ( "FragmentPacket", "Unsupported binary "
+                                "fragment version" );
+    if ( size < headerSize )
+        throw ParserException ( "FragmentPacket", "Truncated binary "
+                                "fragment packet" );
+
+    repairCount = datagram[3];
+    frameId = getU32 ( datagram + 4 );
+    fragmentNumber = getU16 ( datagram + 8 );
+    fragmentCount = getU16 ( datagram + 10 );
+    packetSize = getU32 ( datagram + 12 );
+    packetTimestamp = epoch +
+                      boost::posix_time::microseconds ( getU64 ( datagram + 16 ) );
+
+    struct sockaddr_in saddr;
+    memset ( &saddr, 0, sizeof ( saddr ) );
+    saddr.sin_family = AF_INET;
+    memcpy ( &saddr.sin_addr, datagram + 24, 4 );
+    memcpy ( &saddr.sin_port, datagram + 28, 2 );
+    source = SockAddress ( ( const struct sockaddr * ) &saddr );
+    if ( headerSize > binaryHeaderSizeV1 )
+        fragmentSize = getU16 ( datagram + 30 );
+
+    view = datagram + headerSize;
+    viewSize = size - headerSize;
+}
+
 byte_str FragmentPacket::build() const
 {
     GTTPacket gttpkt;
@@ -80,16 +259,91 @@ byte_str FragmentPacket::build() const
     return gttpkt.build();
 }
 
-void FragmentPacket::fillGttPacket ( GTTPacket& gttpkt ) const
+byte_str FragmentPacket::buildHeader ( WireFormat format ) const
+{
+    if ( format != wireBinary ) {
+        GTTPacket gttpkt;
+        fillGttPacket ( gttpkt, false );
+        return gttpkt.buildHeader ( payloadSize() );
+    }
+
+    byte_str res ( binaryHeaderSize, 0 );
+    byte* p = &res[0];
+
+    putU16 ( p, binaryMagic );
+    p[2] = binaryVersion;
+    p[3] = repairCount;
+    putU32 ( p + 4, frameId );
+    putU16 ( p + 8, fragmentNumber );
+    putU16 ( p + 10, fragmentCount );
+    putU32 ( p + 12, packetSize );
+    putU64 ( p + 16, ( packetTimestamp - epoch ).total_microseconds() );
+
+    // Only IPv4 sources have a binary representation
+    struct sockaddr_storage saddr;
+    source.getSockAddr ( ( struct sockaddr * ) &saddr );
+    EPYX_ASSERT ( saddr.ss_family == AF_INET );
+    const struct sockaddr_in* ipv4 = ( const struct sockaddr_in * ) &saddr;
+    memcpy ( p + 24, &ipv4->sin_addr, 4 );
+    memcpy ( p + 28, &ipv4->sin_port, 2 );
+    putU16 ( p + 30, fragmentSize );
+    return res;
+}
+
+const byte* FragmentPacket::payload() const
+{
+    return view ? view : data.data();
+}
+
+size_t FragmentPacket::payloadSize() const
+{
+    return view ? viewSize : data.size();
+}
+
+bool FragmentPacket::isBinary ( const byte* datagram, size_t size )
+{
+    return size >= binaryHeaderSizeV1 && getU16 ( datagram ) == binaryMagic;
+}
+
+size_t FragmentPacket::maxHeaderSize ( WireFormat format,
+                                       const SockAddress& source )
+{
+    if ( format == wireBinary )
+        return binaryHeaderSize;
+
+    // Longest values of every field, with a 4 digit payload size
+    const ptime time ( boost::gregorian::date ( 2000, 12, 31 ),
+                       boost::posix_time::hours ( 23 ) +
+                       boost::posix_time::minutes ( 59 ) +
+                       boost::posix_time::seconds ( 59 ) +
+                       boost::posix_time::microseconds ( 999999 ) );
+    FragmentPacket packet ( byte_str ( 9999, 0 ), time, 0xffffffff, 0xffff,
+                            0xffff, 0xffffffff, source );
+    packet.fragmentSize = 0xffff;
+    packet.repairCount = 0xff;
+    return packet.buildHeader ( wireGtt ).size();
+}
+
+void FragmentPacket::fillGttPacket ( GTTPacket& gttpkt, bool withBody ) const
 {
     gttpkt.protocol = "VCP2P";
     gttpkt.method = "FRAGMENT";
     gttpkt.headers["Time"] =
         boost::posix_time::to_simple_string ( packetTimestamp );
+    gttpkt.headers["Frame"] =
+        boost::lexical_cast<std::string> ( frameId );
     gttpkt.headers["Number"] =
-        boost::lexical_cast<std::string> ( (int) fragmentNumber );
+        boost::lexical_cast<std::string> ( fragmentNumber );
+    gttpkt.headers["Count"] =
+        boost::lexical_cast<std::string> ( fragmentCount );
     gttpkt.headers["Size"] =
         boost::lexical_cast<std::string> ( packetSize );
+    if ( repairCount > 0 )
+        gttpkt.headers["Repair"] =
+            boost::lexical_cast<std::string> ( ( unsigned int ) repairCount );
+    gttpkt.headers["FragmentSize"] =
+        boost::lexical_cast<std::string> ( fragmentSize );
     gttpkt.headers["Source"] = source.toString();
-    gttpkt.body = data;
+    if ( withBody )
+        gttpkt.body.assign ( payload(), payloadSize() );
 }
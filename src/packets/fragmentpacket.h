@@ -19,41 +19,152 @@
 #define FRAGMENTPACKET_H
 
 #include "parser/gttpacket.h"
+#include "parser/gttparser.h"
 #include "net/sockaddress.h"
 #include <boost/date_time/posix_time/ptime.hpp>
+#include <memory>
 
 using namespace Epyx;
 
+/**
+ * @brief Encoding used on the wire for fragments sent to a peer
+ **/
+enum WireFormat {
+    /** Human readable GTT text packets, kept for debugging */
+    wireGtt,
+    /** Compact fixed-layout binary header */
+    wireBinary
+};
+
 class FragmentPacket : public GTTPacket {
     typedef boost::posix_time::ptime ptime;
 public:
     FragmentPacket ( const byte_str& data, 
 		     ptime packetTimestamp,
-                     unsigned char fragmentNumber,
+		     unsigned int frameId,
+                     unsigned short fragmentNumber,
+		     unsigned short fragmentCount,
 		     unsigned int packetSize,
 		     SockAddress source );
+    /**
+     * @brief Build a fragment which refers to a slice of a shared frame
+     *
+     * The payload is not copied: the fragment keeps a reference to the
+     * frame buffer, which must not be modified afterwards.
+     **/
+    FragmentPacket ( const std::shared_ptr<const byte_str>& frame,
+                     size_t offset,
+                     size_t length,
+                     ptime packetTimestamp,
+                     unsigned int frameId,
+                     unsigned short fragmentNumber,
+                     unsigned short fragmentCount,
+                     SockAddress source );
     /**
      * @brief Parse GTT packet
      **/
     FragmentPacket ( const GTTPacket& gttpkt );
+    /**
+     * @brief Parse a GTT datagram parsed in place
+     *
+     * The payload is a view into the datagram, which must outlive this
+     * packet.
+     **/
+    FragmentPacket ( const GTTDatagram& dgram );
+    /**
+     * @brief Parse a datagram in the binary wire format
+     *
+     * The payload is a view into the datagram, which must outlive this
+     * packet.
+     * @throw ParserException if the datagram is malformed
+     **/
+    FragmentPacket ( const byte* datagram, size_t size );
     /**
      * @brief Build the raw text query for this packet
      * @sa Epyx::GTTPacket::build()
      **/
     byte_str build() const;
+    /**
+     * @brief Build only the header of this packet in the given wire format
+     *
+     * The datagram is this header immediately followed by the payload.
+     **/
+    byte_str buildHeader ( WireFormat format ) const;
+
+    /**
+     * @brief Fragment payload, either owned or a view into a frame or a
+     * received datagram
+     **/
+    const byte* payload() const;
+    size_t payloadSize() const;
+
+    /**
+     * @brief Tell whether a datagram uses the binary wire format
+     **/
+    static bool isBinary ( const byte* datagram, size_t size );
+    /**
+     * @brief Upper bound of the header size of the fragments sent by a host
+     *
+     * The GTT header size depends on the field values, the bound is the
+     * size of a header with the longest values.
+     **/
+    static size_t maxHeaderSize ( WireFormat format, const SockAddress& source );
+
+    /**
+     * @brief Binary header layout, all fields in network byte order:
+     *
+     * magic (2), version (1), repair count (1), frame id (4),
+     * fragment index (2), fragment count (2), frame size (4),
+     * timestamp in microseconds since the epoch (8),
+     * source IPv4 address (4), source port (2), fragment size (2)
+     *
+     * Version 1 headers end before the fragment size, which is then
+     * defaultFragmentSize.
+     **/
+    static const unsigned short binaryMagic = 0x5646;
+    static const unsigned char binaryVersion = 2;
+    static const size_t binaryHeaderSize = 32;
+
+    /**
+     * @brief Fragment size of the peers which do not send it
+     **/
+    static const unsigned short defaultFragmentSize = 1500;
 
     byte_str data;
 
     SockAddress source;
     ptime packetTimestamp;
-    unsigned char fragmentNumber;
+    unsigned int frameId;
+    unsigned short fragmentNumber;
+    unsigned short fragmentCount;
     unsigned int packetSize;
+    /**
+     * @brief Payload size of the data fragments of the frame
+     *
+     * Every data fragment but the last one has this size, so that fragment
+     * i starts at i * fragmentSize in the frame.
+     **/
+    unsigned short fragmentSize;
+    /**
+     * @brief Number of parity fragments sent after the data fragments
+     *
+     * Parity fragments are numbered from fragmentCount. Parity fragment j
+     * is the XOR of the data fragments i such that i % repairCount == j,
+     * padded with zeros to the longest of them.
+     **/
+    unsigned char repairCount;
 
 private:
+    // Frame which the payload is a view of, if any
+    std::shared_ptr<const byte_str> frame;
+    // Payload, when it is not stored in data
+    const byte* view;
+    size_t viewSize;
+
     /**
      * @brief Fills the given GTT packet with information from this packet
      **/
-    void fillGttPacket ( GTTPacket& gttpkt ) const;
+    void fillGttPacket ( GTTPacket& gttpkt, bool withBody = true ) const;
 };
 
 #endif // FRAGMENTPACKET_H
@@ -0,0 +1,77 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+#include "keyframerequestpacket.h"
+
+#include <core/log.h>
+#include <boost/algorithm/string.hpp>
+
+KeyframeRequestPacket::KeyframeRequestPacket ( const SockAddress& source,
+        const SockAddress& destination ) :
+    source ( source ), destination ( destination )
+{
+}
+
+KeyframeRequestPacket::KeyframeRequestPacket ( const GTTPacket& gttpkt )
+{
+    // Check protocol
+    if ( gttpkt.protocol.compare ( "VCP2P" ) ) {
+        log::error << "KeyframeRequest: Incorrect GTT protocol"
+                   << gttpkt.protocol << log::endl;
+        throw ParserException ( "KeyframeRequestPacket", "Invalid keyframe "
+                                "request packet" );
+    }
+
+    if ( gttpkt.method.compare ( "KFREQ" ) ) {
+        log::error << "KeyframeRequest: Incorrect GTT method" << gttpkt.method
+                   << log::endl;
+        throw ParserException ( "KeyframeRequestPacket", "Invalid keyframe "
+                                "request packet" );
+    }
+
+    // Parse headers
+    for ( auto it = gttpkt.headers.begin(); it != gttpkt.headers.end(); it++ ) {
+        if ( boost::iequals ( it->first, "Source" ) )
+            source = SockAddress ( it->second );
+
+        if ( boost::iequals ( it->first, "Destination" ) )
+            destination = SockAddress ( it->second );
+    }
+}
+
+byte_str KeyframeRequestPacket::build () const
+{
+    GTTPacket gttpkt;
+    fillGttPacket ( gttpkt );
+    return gttpkt.build();
+}
+
+void KeyframeRequestPacket::fillGttPacket ( GTTPacket& gttpkt ) const
+{
+    gttpkt.protocol = "VCP2P";
+    gttpkt.method = "KFREQ";
+    gttpkt.headers["Source"] = source.toString();
+    gttpkt.headers["Destination"] = destination.toString();
+}
+
+std::ostream& operator<< ( std::ostream& os, const KeyframeRequestPacket& pkt )
+{
+    os << "Keyframe request from " << pkt.source.toString()
+       << " to " << pkt.destination.toString();
+
+    return os;
+}
@@ -0,0 +1,64 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+
+#ifndef KEYFRAMEREQUESTPACKET_H
+#define KEYFRAMEREQUESTPACKET_H
+
+#include <iostream>
+#include "parser/gttpacket.h"
+#include "net/sockaddress.h"
+
+using namespace Epyx;
+
+/**
+ * @brief Packet asking a sender for a VP8 keyframe
+ *
+ * A receiver sends it when it cannot decode the video of the destination
+ * any more, because a frame failed to decode or a reference frame was lost.
+ **/
+class KeyframeRequestPacket : public GTTPacket {
+
+public:
+    KeyframeRequestPacket ( const SockAddress& source,
+                            const SockAddress& destination );
+    /**
+     * @brief Parse GTT packet
+     **/
+    KeyframeRequestPacket ( const GTTPacket& gttpkt );
+    /**
+     * @brief Build the raw text query for this packet
+     * @sa Epyx::GTTPacket::build()
+     **/
+    byte_str build () const;
+
+    SockAddress source;
+    SockAddress destination;
+
+private:
+    /**
+     * @brief Fills the given GTT packet with information from this packet
+     **/
+    void fillGttPacket ( GTTPacket& gttpkt ) const;
+};
+
+/**
+ * @brief Prints a short description of a keyframe request in an output stream
+ **/
+std::ostream& operator<< ( std::ostream& os, const KeyframeRequestPacket& pkt );
+
+#endif // KEYFRAMEREQUESTPACKET_H
@@ -0,0 +1,105 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+#include "nackpacket.h"
+
+#include <core/log.h>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
+NackPacket::NackPacket ( const SockAddress& source,
+                         const SockAddress& destination, unsigned int frameId,
+                         const std::vector<unsigned short>& fragments ) :
+    source ( source ), destination ( destination ), frameId ( frameId ),
+    fragments ( fragments )
+{
+    if ( this->fragments.size() > maxFragments )
+        this->fragments.resize ( maxFragments );
+}
+
+NackPacket::NackPacket ( const GTTPacket& gttpkt ) : frameId ( 0 )
+{
+    // Check protocol
+    if ( gttpkt.protocol.compare ( "VCP2P" ) ) {
+        log::error << "Nack: Incorrect GTT protocol" << gttpkt.protocol
+                   << log::endl;
+        throw ParserException ( "NackPacket", "Invalid NACK packet" );
+    }
+
+    if ( gttpkt.method.compare ( "NACK" ) ) {
+        log::error << "Nack: Incorrect GTT method" << gttpkt.method
+                   << log::endl;
+        throw ParserException ( "NackPacket", "Invalid NACK packet" );
+    }
+
+    // Parse headers
+    for ( auto it = gttpkt.headers.begin(); it != gttpkt.headers.end(); it++ ) {
+        if ( boost::iequals ( it->first, "Source" ) )
+            source = SockAddress ( it->second );
+
+        if ( boost::iequals ( it->first, "Destination" ) )
+            destination = SockAddress ( it->second );
+
+        if ( boost::iequals ( it->first, "Frame" ) )
+            frameId = boost::lexical_cast<unsigned int> ( it->second );
+
+        if ( boost::iequals ( it->first, "Fragments" ) ) {
+            std::vector<std::string> numbers;
+            boost::split ( numbers, it->second, boost::is_any_of ( "," ) );
+            for ( auto n = numbers.begin(); n != numbers.end() &&
+                    fragments.size() < maxFragments; n++ ) {
+                if ( !n->empty() )
+                    fragments.push_back (
+                        boost::lexical_cast<unsigned short> ( *n ) );
+            }
+        }
+    }
+}
+
+byte_str NackPacket::build () const
+{
+    GTTPacket gttpkt;
+    fillGttPacket ( gttpkt );
+    return gttpkt.build();
+}
+
+void NackPacket::fillGttPacket ( GTTPacket& gttpkt ) const
+{
+    gttpkt.protocol = "VCP2P";
+    gttpkt.method = "NACK";
+    gttpkt.headers["Source"] = source.toString();
+    gttpkt.headers["Destination"] = destination.toString();
+    gttpkt.headers["Frame"] = boost::lexical_cast<std::string> ( frameId );
+
+    std::string numbers;
+    for ( auto it = fragments.begin(); it != fragments.end(); it++ ) {
+        if ( !numbers.empty() )
+            numbers += ",";
+        numbers += boost::lexical_cast<std::string> ( *it );
+    }
+    gttpkt.headers["Fragments"] = numbers;
+}
+
+std::ostream& operator<< ( std::ostream& os, const NackPacket& pkt )
+{
+    os << "NACK from " << pkt.source.toString()
+       << " to " << pkt.destination.toString()
+       << " for " << pkt.fragments.size() << " fragments of frame "
+       << pkt.frameId;
+
+    return os;
+}
@@ -0,0 +1,73 @@
+/*
+    Copyright 2012 <copyright holder> <email>
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+
+
+#ifndef NACKPACKET_H
+#define NACKPACKET_H
+
+#include <iostream>
+#include <vector>
+#include "parser/gttpacket.h"
+#include "net/sockaddress.h"
+
+using namespace Epyx;
+
+/**
+ * @brief Packet asking a sender to retransmit fragments of a frame
+ **/
+class NackPacket : public GTTPacket {
+
+public:
+    NackPacket ( const SockAddress& source, const SockAddress& destination,
+                 unsigned int frameId,
+                 const std::vector<unsigned short>& fragments );
+    /**
+     * @brief Parse GTT packet
+     **/
+    NackPacket ( const GTTPacket& gttpkt );
+    /**
+     * @brief Build the raw text query for this packet
+     * @sa Epyx::GTTPacket::build()
+     **/
+    byte_str build () const;
+
+    SockAddress source;
+    SockAddress destination;
+    unsigned int frameId;
+    /**
+     * @brief Numbers of the missing fragments
+     **/
+    std::vector<unsigned short> fragments;
+
+    /**
+     * @brief Maximum number of fragments asked in one packet
+     **/
+    static const unsigned int maxFragments = 64;
+
+private:
+    /**
+     * @brief Fills the given GTT packet with information from this packet
+     **/
+    void fillGttPacket ( GTTPacket& gttpkt ) const;
+};
+
+/**
+ * @brief Prints a short description of a NACK packet in an output stream
+ **/
+std::ostream& operator<< ( std::ostream& os, const NackPacket& pkt );
+
+#endif // NACKPACKET_H
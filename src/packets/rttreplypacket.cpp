@@ -18,16 +18,21 @@
 #include "rttreplypacket.h"
 
 #include <core/log.h>
+#include <core/string.h>
 #include <boost/algorithm/string.hpp>
 
 RttReplyPacket::RttReplyPacket ( const SockAddress& source,
                                  const SockAddress& destination,
                                  const ptime& sendingTime ) :
-    source ( source ), destination ( destination ), sendingTime ( sendingTime )
+    source ( source ), destination ( destination ), sendingTime ( sendingTime ),
+    hasReport ( false ), framesCompleted ( 0 ), framesLost ( 0 ),
+    framesRecovered ( 0 )
 {
 }
 
-RttReplyPacket::RttReplyPacket ( const GTTPacket& gttpkt )
+RttReplyPacket::RttReplyPacket ( const GTTPacket& gttpkt ) :
+    hasReport ( false ), framesCompleted ( 0 ), framesLost ( 0 ),
+    framesRecovered ( 0 )
 {
     // Check protocol
     if ( gttpkt.protocol.compare ( "VCP2P" ) ) {
@@ -54,6 +59,17 @@ RttReplyPacket::RttReplyPacket ( const GTTPacket& gttpkt )
 
         if ( boost::iequals ( it->first, "Time" ) )
             sendingTime = boost::posix_time::time_from_string ( it->second );
+
+        if ( boost::iequals ( it->first, "Completed" ) ) {
+            framesCompleted = String::toULong ( it->second );
+            hasReport = true;
+        }
+
+        if ( boost::iequals ( it->first, "Lost" ) )
+            framesLost = String::toULong ( it->second );
+
+        if ( boost::iequals ( it->first, "Recovered" ) )
+            framesRecovered = String::toULong ( it->second );
     }
 }
 
@@ -72,6 +88,13 @@ void RttReplyPacket::fillGttPacket ( GTTPacket& gttpkt ) const
     gttpkt.headers["Destination"] = destination.toString();
     gttpkt.headers["Time"] = boost::posix_time::to_simple_string ( sendingTime
                                                                  );
+    if ( hasReport ) {
+        gttpkt.headers["Completed"] =
+            String::fromUnsignedLong ( framesCompleted );
+        gttpkt.headers["Lost"] = String::fromUnsignedLong ( framesLost );
+        gttpkt.headers["Recovered"] =
+            String::fromUnsignedLong ( framesRecovered );
+    }
 }
 
 std::ostream& operator<< ( std::ostream& os, const RttReplyPacket& pkt )
@@ -50,6 +50,20 @@ public:
     SockAddress destination;
     ptime sendingTime;
 
+    /**
+     * @brief Whether the reply carries a reception report
+     *
+     * The report describes the frames the replying host received from the
+     * destination, so that it can adapt its video.
+     */
+    bool hasReport;
+    /** Frames fully received */
+    unsigned long framesCompleted;
+    /** Frames abandoned incomplete or of which nothing arrived */
+    unsigned long framesLost;
+    /** Frames completed thanks to parity fragments */
+    unsigned long framesRecovered;
+
 private:
     /**
      * @brief Fills the given GTT packet with information from this packet
@@ -21,13 +21,16 @@
 #include <boost/algorithm/string.hpp>
 
 RttRequestPacket::RttRequestPacket ( const SockAddress& source,
-                                     const SockAddress& destination ) :
+                                     const SockAddress& destination,
+                                     bool binaryWire ) :
     source ( source ), destination ( destination ),
-    sendingTime ( boost::posix_time::microsec_clock::local_time() )
+    sendingTime ( boost::posix_time::microsec_clock::local_time() ),
+    binaryWire ( binaryWire )
 {
 }
 
-RttRequestPacket::RttRequestPacket ( const GTTPacket& gttpkt )
+RttRequestPacket::RttRequestPacket ( const GTTPacket& gttpkt ) :
+    binaryWire ( false )
 {
     // Check protocol
     if ( gttpkt.protocol.compare ( "VCP2P" ) ) {
@@ -54,6 +57,9 @@ RttRequestPacket::RttRequestPacket ( const GTTPacket& gttpkt )
 
         if ( boost::iequals ( it->first, "Time" ) )
             sendingTime = boost::posix_time::time_from_string ( it->second );
+
+        if ( boost::iequals ( it->first, "Wire" ) )
+            binaryWire = boost::iequals ( it->second, "binary" );
     }
 }
 
@@ -72,6 +78,8 @@ void RttRequestPacket::fillGttPacket ( GTTPacket& gttpkt ) const
     gttpkt.headers["Destination"] = destination.toString();
     gttpkt.headers["Time"] = boost::posix_time::to_simple_string ( sendingTime
                                                                  );
+    if ( binaryWire )
+        gttpkt.headers["Wire"] = "binary";
 }
 
 std::ostream& operator<< ( std::ostream& os, const RttRequestPacket& pkt )
@@ -33,7 +33,8 @@ class RttRequestPacket : public GTTPacket {
     typedef boost::posix_time::ptime ptime;
 
 public:
-    RttRequestPacket ( const SockAddress& source, const SockAddress& destination );
+    RttRequestPacket ( const SockAddress& source, const SockAddress& destination,
+                       bool binaryWire = false );
     /**
      * @brief Parse GTT packet
      **/
@@ -47,6 +48,10 @@ public:
     SockAddress source;
     SockAddress destination;
     ptime sendingTime;
+    /**
+     * @brief The source accepts fragments in the binary wire format
+     **/
+    bool binaryWire;
 
 private:
     /**
@@ -20,6 +20,10 @@ namespace Epyx
     }
 
     byte_str GTTPacket::build() const {
+        return buildHeader(body.size()).append(body);
+    }
+
+    byte_str GTTPacket::buildHeader(size_t bodySize) const {
         std::stringstream head;
 
         // First line
@@ -29,13 +33,12 @@ namespace Epyx
         for (auto it = headers.begin(); it != headers.end(); it++) {
             head << it->first << ": " << it->second << String::crlf;
         }
-        if (body.size() > 0) {
-            head << "content-length: " << body.size() << String::crlf;
+        if (bodySize > 0) {
+            head << "content-length: " << bodySize << String::crlf;
         }
         head << String::crlf;
 
-        // Concatenate headers and content
         std::string header = head.str();
-        return string2bytes(header).append(body);
+        return string2bytes(header);
     }
 }
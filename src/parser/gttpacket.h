@@ -50,6 +50,13 @@ namespace Epyx
          */
         byte_str build() const;
 
+        /**
+         * @brief Build only the raw text header, for a body sent separately
+         * @param bodySize size of the body which follows the header
+         * @return bytes string
+         */
+        byte_str buildHeader(size_t bodySize) const;
+
         /**
          * @brief Protocol name
          */
@@ -97,79 +97,183 @@ namespace Epyx
         return NULL;
     }
 
-    void GTTParser::parseFirstLine(const std::string& line) {
-        const char *l = line.c_str();
-        int i = 0, iMethod = 0;
+    bool GTTDatagram::Token::equals(const char *str) const {
+        return strlen(str) == size && !strncmp(data, str, size);
+    }
+
+    bool GTTDatagram::Token::iequals(const char *str) const {
+        return strlen(str) == size && !strncasecmp(data, str, size);
+    }
+
+    std::string GTTDatagram::Token::str() const {
+        return std::string(data, size);
+    }
+
+    const GTTDatagram::Token* GTTDatagram::header(const char *name) const {
+        for (unsigned int i = 0; i < headerCount; i++) {
+            if (headerNames[i].iequals(name))
+                return &headerValues[i];
+        }
+        return NULL;
+    }
 
-        if (line.length() == 0)
+    void GTTDatagram::toPacket(GTTPacket& pkt) const {
+        pkt.protocol = protocol.str();
+        pkt.method = method.str();
+        pkt.headers.clear();
+        for (unsigned int i = 0; i < headerCount; i++) {
+            pkt.headers[headerNames[i].str()] = headerValues[i].str();
+        }
+        pkt.body.assign(body, bodySize);
+    }
+
+    void GTTParser::parseDatagram(const byte *data, size_t size,
+            GTTDatagram& dgram) {
+        const char *p = (const char *) data;
+        const char *end = p + size;
+        size_t contentLength = 0;
+        bool hasContentLength = false;
+
+        dgram.headerCount = 0;
+
+        // Find the end of the current line, without the CRLF
+        auto lineEnd = [&](const char *start, const char **next) -> const char* {
+            const char *nl = (const char *) memchr(start, '\n', end - start);
+            if (nl == NULL)
+                throw ParserException("GTTParser", "truncated datagram");
+            *next = nl + 1;
+            return (nl > start && nl[-1] == '\r') ? nl - 1 : nl;
+        };
+
+        // First line: PROTOCOL METHOD
+        const char *next;
+        const char *eol = lineEnd(p, &next);
+        splitFirstLine(p, eol, dgram.protocol, dgram.method);
+        p = next;
+
+        // Headers until an empty line
+        while (true) {
+            eol = lineEnd(p, &next);
+            if (p == eol)
+                break;
+            GTTDatagram::Token name, value;
+            splitHeaderLine(p, eol, name, value);
+
+            if (name.iequals("content-length")) {
+                if (hasContentLength)
+                    throw ParserException("GTTParser", "content-length flag has already appeared");
+                contentLength = parseContentLength(value.str());
+                hasContentLength = true;
+            } else {
+                if (dgram.headerCount == GTTDatagram::maxHeaders)
+                    throw ParserException("GTTParser", "too many headers in datagram");
+                dgram.headerNames[dgram.headerCount] = name;
+                dgram.headerValues[dgram.headerCount] = value;
+                dgram.headerCount++;
+            }
+            p = next;
+        }
+
+        // Body
+        p = next;
+        if ((size_t) (end - p) < contentLength)
+            throw ParserException("GTTParser", "truncated datagram body");
+        dgram.body = (const byte *) p;
+        dgram.bodySize = contentLength;
+    }
+
+    void GTTParser::splitFirstLine(const char *begin, const char *end,
+            GTTDatagram::Token& protocol, GTTDatagram::Token& method) {
+        if (begin == end)
             throw ParserException("GTTParser", "empty first line");
 
         // Read protocol name
-        if (!isupper(l[i]))
+        if (!isupper(*begin))
             throw ParserException("GTTParser", "protocol name should begin with capital letters");
-        i++;
-        while (l[i] != ' ') {
-            if (!(isupper(l[i]) || isdigit(l[i]) || (l[i] == '_')))
+        const char *i = begin + 1;
+        while (i < end && *i != ' ') {
+            if (!(isupper(*i) || isdigit(*i) || (*i == '_')))
                 throw ParserException("GTTParser", "protocol name should continue with [A-Z0-9]* or end with a space");
             i++;
         }
-        currentPkt->protocol = std::string(l, i);
+        protocol.data = begin;
+        protocol.size = i - begin;
+        if (i == end)
+            throw ParserException("GTTParser", "missing method name");
         i++;
 
         // Read method name
-        iMethod = i;
-        if (!isupper(l[i]))
+        if (i == end || !isupper(*i))
             throw ParserException("GTTParser", "method name should begin with capital letters");
-        i++;
-        while (l[i] != 0) {
-            if (!(isupper(l[i]) || isdigit(l[i]) || (l[i] == '_')))
+        method.data = i;
+        while (i < end) {
+            if (!(isupper(*i) || isdigit(*i) || (*i == '_')))
                 throw ParserException("GTTParser", "method name should continue with [A-Z0-9]* or end with a space");
             i++;
         }
-        currentPkt->method = std::string(l + iMethod, i - iMethod);
+        method.size = i - method.data;
     }
 
-    void GTTParser::parseHeaderLine(const std::string& line) {
-        const char *l = line.c_str();
-        int i = 0, iValue = 0;
-        EPYX_ASSERT(line.length() != 0);
+    void GTTParser::splitHeaderLine(const char *begin, const char *end,
+            GTTDatagram::Token& name, GTTDatagram::Token& value) {
+        EPYX_ASSERT(begin != end);
 
         // Read flag name
-        if (!isalpha(l[i]))
+        if (!isalpha(*begin))
             throw ParserException("GTTParser", "flag_name should begin with [a-zA-Z] or we should add newline to end the header");
-        i++;
-        while (l[i] != ':') {
-            if (!(isalnum(l[i]) || (l[i] == '_') || (l[i] == '-')))
+        const char *i = begin + 1;
+        while (i < end && *i != ':') {
+            if (!(isalnum(*i) || (*i == '_') || (*i == '-')))
                 throw ParserException("GTTParser", "flag name should continue with [A-Za-z0-9-_]* or end with a space");
             i++;
         }
-        std::string flagName(l, i);
+        if (i == end)
+            throw ParserException("GTTParser", "flag without value");
+        name.data = begin;
+        name.size = i - begin;
         i++;
 
         // Skip spaces
-        while (l[i] == ' ')
+        while (i < end && *i == ' ')
             i++;
-        if (l[i] == 0)
+        if (i == end)
             throw ParserException("GTTParser", "flag without value");
 
         // Read value
-        iValue = i;
-        while (l[i] != 0) {
-            if (!(l[i] >= 32 && l[i] < 126))
+        value.data = i;
+        value.size = end - i;
+        for (; i < end; i++) {
+            if (!(*i >= 32 && *i < 126))
                 throw ParserException("GTTParser", "flag_value should consist of printable characters or just end with CRLF");
-            i++;
         }
-        std::string flagValue(l + iValue, i - iValue);
+    }
+
+    size_t GTTParser::parseContentLength(const std::string& value) {
+        long n = String::toInt(value);
+        if (n <= 0)
+            throw ParserException("GTTParser", "not valid body size, body size should be a positive integer");
+        return n;
+    }
+
+    void GTTParser::parseFirstLine(const std::string& line) {
+        GTTDatagram::Token protocol, method;
+        splitFirstLine(line.data(), line.data() + line.length(), protocol,
+                method);
+        currentPkt->protocol = protocol.str();
+        currentPkt->method = method.str();
+    }
+
+    void GTTParser::parseHeaderLine(const std::string& line) {
+        GTTDatagram::Token name, value;
+        splitHeaderLine(line.data(), line.data() + line.length(), name, value);
 
         // Content length
-        if (!strcasecmp(flagName.c_str(), "content-length")) {
+        if (name.iequals("content-length")) {
             if (currentSize > 0)
                 throw ParserException("GTTParser", "content-length flag has already appeared");
-            currentSize = String::toInt(flagValue);
-            if (currentSize <= 0)
-                throw ParserException("GTTParser", "not valid body size, body size should be a positive integer");
+            currentSize = parseContentLength(value.str());
         } else {
-            currentPkt->headers[flagName] = flagValue;
+            currentPkt->headers[name.str()] = value.str();
         }
     }
 }
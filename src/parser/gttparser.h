@@ -29,6 +29,62 @@
 
 namespace Epyx
 {
+    /**
+     * @struct GTTDatagram
+     *
+     * @brief GTT packet parsed in place, which refers to the parsed buffer
+     */
+    struct GTTDatagram
+    {
+        /**
+         * @brief Piece of text inside the parsed buffer
+         */
+        struct Token
+        {
+            const char *data;
+            size_t size;
+
+            /**
+             * @brief Case-sensitive comparison with a C string
+             */
+            bool equals(const char *str) const;
+            /**
+             * @brief Case-insensitive comparison with a C string
+             */
+            bool iequals(const char *str) const;
+            /**
+             * @brief Copy the token in a string
+             */
+            std::string str() const;
+        };
+
+        /**
+         * @brief Maximum number of headers in a datagram
+         */
+        static const unsigned int maxHeaders = 16;
+
+        Token protocol;
+        Token method;
+        Token headerNames[maxHeaders];
+        Token headerValues[maxHeaders];
+        unsigned int headerCount;
+        const byte *body;
+        size_t bodySize;
+
+        /**
+         * @brief Find a header, case-insensitively
+         * @param name header name
+         * @return the value, or NULL if there is no such header
+         */
+        const Token* header(const char *name) const;
+
+        /**
+         * @brief Copy everything into a GTTPacket
+         * @param pkt packet to fill
+         */
+        void toPacket(GTTPacket& pkt) const;
+    };
+
     /**
      * @class GTTParser
      *
@@ -65,6 +121,19 @@ namespace Epyx
          */
         std::unique_ptr<GTTPacket> getPacket();
 
+        /**
+         * @brief Parse one complete datagram in place, without any state
+         *
+         * Unlike eat() and getPacket(), a datagram is never mixed with the
+         * previous or the next one, so a bad datagram is simply dropped.
+         * @param data datagram content, which must outlive dgram
+         * @param size datagram size
+         * @param dgram views into data
+         * @throw ParserException if the datagram is not a complete GTT packet
+         */
+        static void parseDatagram(const byte *data, size_t size,
+                GTTDatagram& dgram);
+
     protected:
         /**
          * @brief Current GTT Packet
@@ -111,6 +180,27 @@ namespace Epyx
          * @brief start a new packet, without cleaning read data
          */
         void startPacket();
+
+        /**
+         * @brief Split a first line, without its CRLF, into its names
+         * @throw ParserException on errors
+         */
+        static void splitFirstLine(const char *begin, const char *end,
+                GTTDatagram::Token& protocol, GTTDatagram::Token& method);
+
+        /**
+         * @brief Split a non-empty header line, without its CRLF, into its
+         * name and value
+         * @throw ParserException on errors
+         */
+        static void splitHeaderLine(const char *begin, const char *end,
+                GTTDatagram::Token& name, GTTDatagram::Token& value);
+
+        /**
+         * @brief Check and convert the value of a content-length header
+         * @throw ParserException if it is not a positive integer
+         */
+        static size_t parseContentLength(const std::string& value);
     };
 }
 
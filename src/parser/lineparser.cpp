@@ -6,14 +6,28 @@ namespace Epyx
 {
 
     LineParser::LineParser()
-    :buffer() {
+    :buffer(), start(0), scanned(0) {
     }
 
     void LineParser::reset() {
         buffer.clear();
+        start = 0;
+        scanned = 0;
     }
 
     void LineParser::push(const byte_str& data) {
+        if (start == buffer.size()) {
+            // Everything has been read
+            buffer.clear();
+            start = 0;
+            scanned = 0;
+        } else if (start > 0 && start >= buffer.size() - start) {
+            // Most of the buffer has been read, compact it
+            buffer.erase(0, start);
+            scanned -= start;
+            start = 0;
+        }
+
         if (buffer.empty()) {
             buffer.assign(data);
         } else {
@@ -22,28 +36,41 @@ namespace Epyx
     }
 
     bool LineParser::popLine(std::string& line) {
-        size_t i = 0;
-        for (auto it = buffer.begin(); it != buffer.end(); ++it, ++i) {
-            if (*it == '\n') {
-                size_t iend = (i > 0 && *(it - 1) == '\r') ? i - 1 : i;
-                line.assign((const char*) buffer.substr(0, iend).c_str(), iend);
-                buffer.erase(buffer.begin(), it + 1);
-                return true;
-            }
+        // Resume the search where the previous one stopped
+        const byte *begin = buffer.data();
+        const byte *nl = (const byte*) memchr(begin + scanned, '\n',
+            buffer.size() - scanned);
+        if (nl == NULL) {
+            scanned = buffer.size();
+            return false;
         }
-        return false;
+
+        size_t i = nl - begin;
+        size_t iend = (i > start && begin[i - 1] == '\r') ? i - 1 : i;
+        line.assign((const char*) begin + start, iend - start);
+        start = i + 1;
+        scanned = start;
+        return true;
     }
 
     bool LineParser::popData(byte_str *data, size_t size) {
         EPYX_ASSERT(size > 0 && data != NULL);
 
         // Not enough bytes in the buffer
-        if (size > buffer.size())
+        if (size > buffer.size() - start)
             return false;
 
+        if (start == 0 && size == buffer.size()) {
+            // Hand the whole buffer out
+            data->swap(buffer);
+            this->reset();
+            return true;
+        }
+
         // Read data
-        data->assign(buffer.substr(0, size));
-        buffer.erase(0, size);
+        data->assign(buffer, start, size);
+        start += size;
+        scanned = start;
         return true;
     }
 }
@@ -30,6 +30,11 @@ namespace Epyx
      * @class LineParser
      *
      * @brief Cut raw data into lines
+     *
+     * Consumed data is not erased from the front of the buffer each time
+     * a line is read: a read cursor moves forward instead and the buffer
+     * is compacted only once most of it has been consumed, so that every
+     * byte is moved at most a constant number of times.
      */
     class LineParser
     {
@@ -68,6 +73,12 @@ namespace Epyx
     private:
         // Internal buffer
         byte_str buffer;
+
+        // Read cursor in buffer
+        size_t start;
+
+        // Position up to which buffer has no newline character
+        size_t scanned;
     };
 }
 
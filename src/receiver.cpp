@@ -20,6 +20,8 @@
 #include "parser/gttpacket.h"
 #include "packets/rttreplypacket.h"
 #include "packets/rttrequestpacket.h"
+#include "packets/keyframerequestpacket.h"
+#include "packets/nackpacket.h"
 #include "core/log.h"
 #include "user.h"
 #include "videoconferencep2p.h"
@@ -28,6 +30,8 @@
 
 using namespace Epyx;
 
+const unsigned int Receiver::datagramSize;
+
 Receiver::Receiver ( VideoConferenceP2P* vc ) : conference ( vc )
 {
 
@@ -35,48 +39,113 @@ Receiver::Receiver ( VideoConferenceP2P* vc ) : conference ( vc )
 
 void Receiver::run()
 {
-    GTTParser parser;
-    int size;
     UDPServer& server = conference->getServer();
-    RTTManager* rttManager = conference->getRTTManager();
-
-    const int MAX = 4096;
-    byte data[MAX];
-    std::unique_ptr<GTTPacket> packet;
+    UDPRecvBatch batch ( batchSize, datagramSize );
+    unsigned long truncated = 0;
 
     while ( true ) {
+        const int count = server.recvBatch ( batch );
+        if ( batch.truncatedCount() != truncated ) {
+            truncated = batch.truncatedCount();
+            log::debug << "Error: dropped " << truncated << " datagrams "
+                       "larger than " << datagramSize << " bytes so far"
+                       << log::endl;
+        }
+        for ( int i = 0; i < count; i++ )
+            handleDatagram ( batch.data ( i ), batch.length ( i ),
+                             batch.address ( i ) );
+    }
+}
 
-        size = server.recv ( data,MAX );
-        parser.eat ( byte_str ( data, size ) );
-
-        while ( ( packet =  parser.getPacket() ) != nullptr ) {
-
-            if ( packet->method.compare ( "RTTREQ" ) == 0 ) {
-                RttRequestPacket request ( * ( packet.get() ) );
+/**
+ * @brief Dispatch one received datagram
+ *
+ * @param data datagram content, only valid during this call
+ * @param size datagram size
+ * @param from address the datagram was received from
+ */
+void Receiver::handleDatagram ( const byte* data, unsigned int size,
+                                const struct sockaddr* from )
+{
+    try {
+        if ( FragmentPacket::isBinary ( data, size ) ) {
+            FragmentPacket fragment ( data, size );
+            User* user = conference->findUser ( fragment.source );
+            if ( display && user )
+                user->receive ( fragment );
+            return;
+        }
 
-                RttReplyPacket reply ( request.destination,
-                                       request.source,
-                                       request.sendingTime );
-                const byte_str replyPacket = reply.build();
+        // Each datagram holds exactly one GTT packet
+        GTTDatagram dgram;
+        GTTParser::parseDatagram ( data, size, dgram );
+        handleGttDatagram ( dgram, from );
+    } catch ( std::exception& e ) {
+        log::debug << "Error: dropped datagram, " << e.what() << log::endl;
+    }
+}
 
-                //Epyx::log::debug <<  reply << Epyx::log::endl;
-                server.sendTo ( reply.destination,
-                                replyPacket.data(),
-                                replyPacket.size() );
+void Receiver::handleGttDatagram ( const GTTDatagram& dgram,
+                                   const struct sockaddr* from )
+{
+    UDPServer& server = conference->getServer();
+    RTTManager* rttManager = conference->getRTTManager();
 
-            } else if ( packet->method.compare ( "RTTREP" ) == 0 ) {
-                RttReplyPacket reply ( * ( packet.get() ) );
+    // Source headers come from the datagrams, packets naming peers which
+    // are not users of the conference are dropped
+    if ( dgram.method.equals ( "FRAGMENT" ) ) {
+        FragmentPacket fragment ( dgram );
+        User* user = conference->findUser ( fragment.source );
+        if ( display && user )
+            user->receive ( fragment );
+        return;
+    }
 
-                rttManager->processRTT ( reply );
-            } else if ( packet->method.compare ( "FRAGMENT" ) == 0 ) {
-                FragmentPacket fragment ( * ( packet.get() ) );
-                if ( display )
-                    conference->getUser ( fragment.source )->
-                    receive ( fragment );
-            } else {
-                log::debug << "Error: Unrecognized packet" << log::endl;
-            }
-        }
+    // Control packets are rare, they may use the full GTTPacket
+    GTTPacket packet;
+    dgram.toPacket ( packet );
+
+    if ( packet.method.compare ( "RTTREQ" ) == 0 ) {
+        RttRequestPacket request ( packet );
+        User* user = conference->findUser ( request.source );
+        if ( !user )
+            return;
+        user->setWireFormat (
+            request.binaryWire && conference->useBinaryWire() ?
+            wireBinary : wireGtt );
+
+        RttReplyPacket reply ( request.destination,
+                               request.source,
+                               request.sendingTime );
+        // Tell the requester how well its video gets here
+        const FragmentStats stats = user->getFragmentStats();
+        reply.hasReport = true;
+        reply.framesCompleted = stats.completed;
+        reply.framesLost = stats.abandoned + stats.missing;
+        reply.framesRecovered = stats.recovered;
+        const byte_str replyPacket = reply.build();
+
+        //Epyx::log::debug <<  reply << Epyx::log::endl;
+        server.sendTo ( reply.destination,
+                        replyPacket.data(),
+                        replyPacket.size() );
+
+    } else if ( packet.method.compare ( "KFREQ" ) == 0 ) {
+        KeyframeRequestPacket request ( packet );
+        conference->requestKeyframe();
+    } else if ( packet.method.compare ( "NACK" ) == 0 ) {
+        // The Source header is not authenticated, answer where it came from
+        NackPacket nack ( packet );
+        conference->retransmit ( SockAddress ( from ), nack.frameId,
+                                 nack.fragments );
+    } else if ( packet.method.compare ( "RTTREP" ) == 0 ) {
+        RttReplyPacket reply ( packet );
+        if ( !conference->findUser ( reply.source ) )
+            return;
+
+        rttManager->processRTT ( reply );
+    } else {
+        log::debug << "Error: Unrecognized packet" << log::endl;
     }
 }
 
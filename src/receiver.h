@@ -22,6 +22,7 @@
 #include "net/sockaddress.h"
 #include "boost/shared_ptr.hpp"
 #include "core/thread.h"
+#include "parser/gttparser.h"
 
 class VideoConferenceP2P;
 
@@ -34,7 +35,21 @@ public:
     void run();
     void setDisplay( bool d);
 
+    /**
+     * @brief Maximum number of datagrams drained by one system call
+     */
+    static const unsigned int batchSize = 64;
+    /**
+     * @brief Size of each receive buffer
+     */
+    static const unsigned int datagramSize = 4096;
+
 private:
+    void handleDatagram ( const byte* data, unsigned int size,
+                          const struct sockaddr* from );
+    void handleGttDatagram ( const GTTDatagram& dgram,
+                             const struct sockaddr* from );
+
     VideoConferenceP2P* conference;
     bool display = true;
 };
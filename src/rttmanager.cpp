@@ -19,6 +19,7 @@
 #include "videoconferencep2p.h"
 #include "packets/rttrequestpacket.h"
 #include "core/log.h"
+#include "congestioncontroller.h"
 
 RTTManager::RTTManager ( VideoConferenceP2P* vc ) :
     conference ( vc )
@@ -58,6 +59,11 @@ void RTTManager::processRTT ( const RttReplyPacket& packet )
 
     conference->updateDelay ( packet.source, delay );
 
+    if ( packet.hasReport )
+        conference->getCongestionController()->report (
+            packet.source, 2 * delay, packet.framesCompleted,
+            packet.framesLost, packet.framesRecovered );
+
     /* Epyx::log::debug << "RTT update for " <<
                      packet.source.getPort() <<
                      " set to "<<
@@ -71,7 +77,8 @@ void RTTManager::run()
         for ( auto dest = users.begin() ; dest != users.end(); dest++ ) {
             if ( conference->host != dest->first ) {
 
-                RttRequestPacket rp ( conference->host,dest->first );
+                RttRequestPacket rp ( conference->host, dest->first,
+                                      conference->useBinaryWire() );
                 const byte_str packet = rp.build();
 
                 //Epyx::log::debug << rp << Epyx::log::endl;
@@ -17,26 +17,90 @@
 
 #include "sender.h"
 #include "videoconferencep2p.h"
+#include "framesource.h"
+#include "congestioncontroller.h"
+#include "webm/vpxencoder.h"
 #include <iostream>
+#include <algorithm>
 #include "boost/lexical_cast.hpp"
 #include <QApplication>
+#include <boost/date_time/posix_time/posix_time.hpp>
 
-const int sendingDelay = 1000 / 24;
+// Time between two frames, in microseconds
+const unsigned long frameInterval = 1000000 / 24;
+const unsigned int statsInterval = 24 * 10;
 
-Sender::Sender ( VideoConferenceP2P* vc ) : conference ( vc )
+// Number of NACKs served between two retransmission reports
+const unsigned int nackStatsInterval = 100;
+
+using namespace boost::posix_time;
+
+const unsigned int Sender::videoWidth;
+const unsigned int Sender::videoHeight;
+
+Sender::Sender ( VideoConferenceP2P* vc ) : conference ( vc ),
+    source ( "jpeg" ), keyframeRequested ( false ), stopped ( false ),
+    byteCount ( 0 ),
+    frameCount ( 0 ), serializationTime ( 0 ),
+    oversized ( 0 ), frameClock ( frameInterval ), retransmitTokens ( 0 ),
+    lastRefill ( microsec_clock::local_time() ),
+    nackCount ( 0 ), retransmitted ( 0 ), retransmitLimited ( 0 ),
+    retransmitExpired ( 0 )
+{
+
+}
+
+void Sender::setSource ( const std::string& source )
+{
+    this->source = source;
+}
+
+void Sender::requestKeyframe()
 {
+    keyframeRequested = true;
+}
 
+void Sender::stop()
+{
+    stopped = true;
+}
+
+void Sender::setPacingBurst ( unsigned int burst )
+{
+    pacer.setBurst ( burst );
 }
 
 void Sender::run()
+{
+    headerSize[wireGtt] =
+        FragmentPacket::maxHeaderSize ( wireGtt, conference->host );
+    headerSize[wireBinary] =
+        FragmentPacket::maxHeaderSize ( wireBinary, conference->host );
+    Epyx::log::debug << "Sender: MTU " << conference->getMtu()
+                     << ", fragment headers up to " << headerSize[wireGtt]
+                     << " bytes in GTT and " << headerSize[wireBinary]
+                     << " bytes in binary" << Epyx::log::endl;
+
+    if ( source == "jpeg" )
+        runJpeg();
+    else
+        runVp8();
+    qApp->quit();
+}
+
+/**
+ * @brief Replay the JPEG pictures of the frames directory
+ */
+void Sender::runJpeg()
 {
     ifstream indata;
     const int initial = 9458;
     const int final = 10906;
     int size;
-    char * memblock;
+    unsigned int frameId = 0;
 
-    for ( int i = initial; i <= final; i++ ) {
+    frameClock.start();
+    for ( int i = initial; i <= final && !stopped; i++ ) {
         indata.open ( "frames/Picture" +
                       boost::lexical_cast<std::string> ( i ) +
                       ".jpg", ios::binary|ios::ate );
@@ -45,32 +109,319 @@ void Sender::run()
             continue;
         }
 
+        // Read the file straight into the buffer the fragments refer to
         size = indata.tellg();
-        memblock = new char [size];
+        std::shared_ptr<byte_str> frame ( new byte_str ( size, 0 ) );
         indata.seekg ( 0, ios::beg );
-        indata.read ( memblock, size );
+        indata.read ( reinterpret_cast<char*> ( &( *frame ) [0] ), size );
         indata.close();
 
 
+        const unsigned int fragment = fragmentSize();
         std::vector<FragmentPacket> list =
-            FragmentManager::cut ( memblock, size );
-        const map< SockAddress, User* >& users = conference->getUsers();
+            FragmentManager::cut ( frame, frameId++, fragment,
+                                   repairCount ( frame->size(), fragment ) );
+        sendFrame ( list );
+        // Replay in real time, the pictures of skipped frame times are lost
+        i += frameClock.wait();
+    }
+}
 
-        for ( unsigned int i = 0; i < list.size(); i++ ) {
-            FragmentPacket fp = list[i];
+/**
+ * @brief Halve an image in both dimensions, averaging the pixels
+ */
+static void downscale ( const vpx_image_t* src, vpx_image_t* dst )
+{
+    for ( int plane = VPX_PLANE_Y; plane <= VPX_PLANE_V; plane++ ) {
+        const unsigned int w = plane == VPX_PLANE_Y ?
+                               dst->d_w : ( dst->d_w + 1 ) / 2;
+        const unsigned int h = plane == VPX_PLANE_Y ?
+                               dst->d_h : ( dst->d_h + 1 ) / 2;
+        for ( unsigned int y = 0; y < h; y++ ) {
+            const byte* a = src->planes[plane] + 2 * y * src->stride[plane];
+            const byte* b = a + src->stride[plane];
+            byte* out = dst->planes[plane] + y * dst->stride[plane];
+            for ( unsigned int x = 0; x < w; x++ )
+                out[x] = ( a[2 * x] + a[2 * x + 1] +
+                           b[2 * x] + b[2 * x + 1] + 2 ) / 4;
+        }
+    }
+}
 
-            for ( auto dest = users.begin() ; dest != users.end(); dest++ ) {
-                fp.source = conference->host;
-                const byte_str packet = fp.build ();
-                dest->second->send ( packet.data() , packet.length() );
+/**
+ * @brief Encode the frames of a FrameSource with VP8 and send them
+ *
+ * Inter frames only carry the changes since the previous frames, which is
+ * far smaller than a JPEG picture per frame.
+ */
+void Sender::runVp8()
+{
+    std::unique_ptr<FrameSource> frames (
+        FrameSource::create ( source, videoWidth, videoHeight ) );
+    if ( !frames ) {
+        Epyx::log::error << "Sender: no video source " << source
+                         << Epyx::log::endl;
+        return;
+    }
+
+    // The camera writes the planes contiguously
+    vpx_image_t* raw = vpx_img_alloc ( NULL, VPX_IMG_FMT_YV12, videoWidth,
+                                       videoHeight, 1 );
+    webm::VpxEncoderConfig config ( videoWidth, videoHeight );
+    config.bitrate = videoBitrate;
+    webm::VpxEncoder encoder ( config );
+    Epyx::log::debug << "Sender: VP8 " << videoWidth << "x" << videoHeight
+                     << " at " << config.bitrate << " kbit/s, "
+                     << config.threads << " threads, "
+                     << ( 1 << config.token_partitions ) << " partitions, "
+                     << "cpu-used " << config.cpu_used << Epyx::log::endl;
+    vpx_image_t* small = vpx_img_alloc ( NULL, VPX_IMG_FMT_YV12,
+                                         videoWidth / 2, videoHeight / 2, 1 );
+    VideoTarget current = { config.bitrate, 1, 0 };
+    const ptime start = microsec_clock::local_time();
+    ptime lastKeyframe = start;
+    unsigned int frameId = 0;
+
+    // The encoder setup is not counted as lateness of the first frame times
+    frameClock.start();
+    while ( !stopped ) {
+        // Follow the network conditions reported by the receivers
+        const VideoTarget target =
+            conference->getCongestionController()->getTarget();
+        if ( target.bitrate != current.bitrate ||
+                target.scale != current.scale ) {
+            if ( encoder.reconfigure ( target.bitrate,
+                                       videoWidth / target.scale,
+                                       videoHeight / target.scale ) )
+                current = target;
+        }
 
-                // Epyx::log::debug << fp << Epyx::log::endl;
+        if ( frames->getFrame ( raw ) ) {
+            const unsigned long time =
+                ( microsec_clock::local_time() - start ).total_milliseconds();
+            if ( current.scale > 1 )
+                downscale ( raw, small );
+            // The first frame must be a keyframe to start the decoders
+            const ptime now = microsec_clock::local_time();
+            bool keyframe = frameId == 0;
+            if ( keyframeRequested && ( now - lastKeyframe ).total_milliseconds()
+                    >= keyframeInterval ) {
+                keyframeRequested = false;
+                keyframe = true;
+            }
+            if ( keyframe )
+                lastKeyframe = now;
+            encoder.encode ( current.scale > 1 ? *small : *raw, time,
+                             keyframe ? VPX_EFLAG_FORCE_KF : 0 );
+
+            std::unique_ptr<webm::FramePacket> packet;
+            while ( ( packet = encoder.getPacket() ) ) {
+                std::shared_ptr<byte_str> frame ( new byte_str() );
+                frame->swap ( packet->data );
+                const unsigned int fragment = fragmentSize();
+                std::vector<FragmentPacket> list =
+                    FragmentManager::cut ( frame, frameId++, fragment,
+                                           repairCount ( frame->size(),
+                                                         fragment ) );
+                sendFrame ( list );
             }
         }
-        delete[] memblock;
-        usleep ( sendingDelay*1000 );
+        // Live sources do not queue the frames of skipped frame times
+        frameClock.wait();
+    }
+    vpx_img_free ( small );
+    vpx_img_free ( raw );
+}
+
+/**
+ * @brief Largest fragment payload whose datagrams fit in the MTU
+ *
+ * Fragments are shared by every user, so the header of the largest wire
+ * format in use is accounted for.
+ */
+unsigned int Sender::fragmentSize() const
+{
+    const map< SockAddress, User* >& users = conference->getUsers();
+    size_t header = headerSize[wireBinary];
+    for ( auto it = users.begin(); it != users.end(); it++ )
+        header = std::max ( header, headerSize[it->second->getWireFormat()] );
+    return conference->getMtu() - datagramOverhead - header;
+}
+
+/**
+ * @brief Number of parity fragments for a frame, following the losses
+ *        reported by the receivers
+ */
+unsigned int Sender::repairCount ( unsigned int frameSize,
+                                   unsigned int fragmentSize ) const
+{
+    const unsigned int rate =
+        conference->getCongestionController()->getTarget().repairRate;
+    const unsigned int fragments =
+        ( frameSize + fragmentSize - 1 ) / fragmentSize;
+    return ( fragments * rate + 99 ) / 100;
+}
+
+/**
+ * @brief Send every fragment of a frame to every user
+ *
+ * Each fragment header is serialized at most once per wire format and the
+ * same immutable buffer is handed to every user that accepts this format.
+ * All the datagrams of the frame are then paced over the frame interval,
+ * and the frame is kept for retransmissions.
+ */
+void Sender::sendFrame ( std::vector<FragmentPacket>& list )
+{
+    if ( list.empty() )
+        return;
+
+    const map< SockAddress, User* >& users = conference->getUsers();
+    const unsigned int mtu = conference->getMtu();
+    time_duration elapsed;
+    unsigned int built = 0;
+    unsigned int bytes = 0;
+    unsigned long batchBytes = 0;
+
+    // Headers must not move until the batch is sent
+    std::shared_ptr<CachedFrame> frame ( new CachedFrame() );
+    frame->fragments.swap ( list );
+    const std::vector<FragmentPacket>& fragments = frame->fragments;
+    frame->headers[wireGtt].resize ( fragments.size() );
+    frame->headers[wireBinary].resize ( fragments.size() );
+    std::vector<UDPDatagram> batch;
+    batch.reserve ( fragments.size() * users.size() );
+
+    for ( unsigned int i = 0; i < fragments.size(); i++ ) {
+        frame->fragments[i].source = conference->host;
+        bytes += fragments[i].payloadSize();
+
+        for ( auto dest = users.begin() ; dest != users.end(); dest++ ) {
+            const WireFormat format = dest->second->getWireFormat();
+            if ( frame->headers[format][i].empty() ) {
+                ptime start = microsec_clock::local_time();
+                frame->buildHeader ( i, format );
+                elapsed += microsec_clock::local_time() - start;
+                built++;
+            }
+
+            const byte_str& header = frame->headers[format][i];
+            batchBytes += header.length() + fragments[i].payloadSize();
+            if ( header.length() + fragments[i].payloadSize() +
+                    datagramOverhead > mtu )
+                oversized++;
+            UDPDatagram dgram;
+            dgram.address = dest->first;
+            dgram.iov[0].iov_base = const_cast<byte*> ( header.data() );
+            dgram.iov[0].iov_len = header.length();
+            dgram.iov[1].iov_base = const_cast<byte*> ( fragments[i].payload() );
+            dgram.iov[1].iov_len = fragments[i].payloadSize();
+            dgram.iovcnt = 2;
+            batch.push_back ( dgram );
+
+            // Epyx::log::debug << fragments[i] << Epyx::log::endl;
+        }
+    }
+
+    // Lost fragments may be asked again while the frame is being paced
+    cache.store ( fragments.front().frameId, frame );
+
+    // Spread the frame at the bitrate, but never beyond the frame interval
+    const double rate = std::max (
+        conference->getCongestionController()->getTarget().bitrate *
+        1000.0 / 8 * users.size() * pacingRate / 100,
+        batchBytes * 1000000.0 / frameInterval );
+    pacer.send ( conference->getServer(), batch, rate );
+
+    serializationTime += elapsed.total_microseconds();
+    byteCount += bytes;
+    if ( ++frameCount % statsInterval == 0 ) {
+        const PacerStats pacing = pacer.getStats();
+        Epyx::log::debug << "Sender: " << fragments.size() << " fragments, "
+                         << byteCount / frameCount << " bytes per frame, "
+                         << built << " headers serialized for "
+                         << users.size() << " users, "
+                         << serializationTime / frameCount
+                         << " us per frame on average, "
+                         << oversized << " datagrams over the MTU, "
+                         << "pacing delay " << pacing.averageDelay
+                         << " us on average and up to " << pacing.maxDelay
+                         << " us" << Epyx::log::endl;
+        const FrameClockStats timing = frameClock.getStats();
+        Epyx::log::debug << "Sender: " << timing.fps << " fps, "
+                         << timing.skipped << " frames skipped, "
+                         << "frame time jitter " << timing.jitter
+                         << " us on average and up to " << timing.maxJitter
+                         << " us" << Epyx::log::endl;
+    }
+}
+
+/**
+ * @brief Send again the fragments a peer lost
+ *
+ * Retransmissions of all the peers share a budget of maxRetransmitRate % of
+ * the video bitrate, so that many receivers losing the same frame cannot
+ * make the sender flood the network. Fragments beyond the budget are not
+ * sent, the receivers ask for them again if there is still time.
+ */
+void Sender::retransmit ( const SockAddress& peer, unsigned int frameId,
+                          const std::vector<unsigned short>& numbers )
+{
+    User* user = conference->findUser ( peer );
+    if ( !user )
+        return;
+
+    // Refill the budget, allowing bursts of a quarter of a second
+    const ptime now = microsec_clock::local_time();
+    const double rate =
+        conference->getCongestionController()->getTarget().bitrate *
+        1000.0 / 8 * maxRetransmitRate / 100;
+    retransmitTokens = std::min ( rate / 4, retransmitTokens +
+                                  rate * ( now - lastRefill ).total_microseconds()
+                                  / 1000000 );
+    lastRefill = now;
+
+    std::shared_ptr<CachedFrame> frame = cache.find ( frameId );
+    if ( !frame ) {
+        retransmitExpired += numbers.size();
+    } else {
+        const WireFormat format = user->getWireFormat();
+        std::vector<UDPDatagram> batch;
+        batch.reserve ( numbers.size() );
+
+        for ( auto n = numbers.begin(); n != numbers.end(); n++ ) {
+            if ( *n >= frame->fragments.size() )
+                continue;
+            const FragmentPacket& fp = frame->fragments[*n];
+            frame->buildHeader ( *n, format );
+            const byte_str& header = frame->headers[format][*n];
+            const unsigned int size = header.length() + fp.payloadSize();
+            if ( retransmitTokens < size ) {
+                retransmitLimited += numbers.end() - n;
+                break;
+            }
+            retransmitTokens -= size;
+
+            UDPDatagram dgram;
+            dgram.address = peer;
+            dgram.iov[0].iov_base = const_cast<byte*> ( header.data() );
+            dgram.iov[0].iov_len = header.length();
+            dgram.iov[1].iov_base = const_cast<byte*> ( fp.payload() );
+            dgram.iov[1].iov_len = fp.payloadSize();
+            dgram.iovcnt = 2;
+            batch.push_back ( dgram );
+        }
+
+        conference->getServer().sendBatch ( batch );
+        retransmitted += batch.size();
+    }
+
+    if ( ++nackCount % nackStatsInterval == 0 ) {
+        Epyx::log::debug << "Sender: " << nackCount << " NACKs, "
+                         << retransmitted << " fragments retransmitted, "
+                         << retransmitLimited << " over the rate limit, "
+                         << retransmitExpired << " no longer cached"
+                         << Epyx::log::endl;
     }
-    qApp->quit();
 }
 
 
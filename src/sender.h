@@ -20,6 +20,15 @@
 
 #include "core/thread.h"
 #include "core/log.h"
+#include "packets/fragmentpacket.h"
+#include "fragmentcache.h"
+#include "pacer.h"
+#include "frameclock.h"
+#include "net/sockaddress.h"
+#include <boost/date_time/posix_time/ptime.hpp>
+#include <atomic>
+#include <string>
+#include <vector>
 
 class VideoConferenceP2P;
 
@@ -31,8 +40,103 @@ public:
     Sender(VideoConferenceP2P* vc);
     void run();
 
+    /**
+     * @brief Choose what is sent, before the thread is started
+     * @param source "jpeg" to replay the JPEG files, otherwise a VP8
+     *        FrameSource name: "camera", "synthetic" or a raw YV12 file
+     */
+    void setSource ( const std::string& source );
+
+    /**
+     * @brief Ask for a VP8 keyframe, from any thread
+     *
+     * Requests received less than keyframeInterval after the last forced
+     * keyframe are served together once the interval is over.
+     */
+    void requestKeyframe();
+    /**
+     * @brief Make the sending loop end after the current frame
+     */
+    void stop();
+
+    /**
+     * @brief Set how many bytes may be sent at once, before the thread
+     *        is started
+     */
+    void setPacingBurst ( unsigned int burst );
+
+    /**
+     * @brief Send again some fragments of a recent frame to a peer
+     *
+     * Served from the cache of the last frames sent, without encoding or
+     * serializing them again. Peers which are not users of the conference
+     * are ignored. Must only be called by the receiver thread.
+     * @param peer address of the user which lost the fragments
+     * @param frameId frame the fragments belong to
+     * @param fragments numbers of the lost fragments
+     */
+    void retransmit ( const SockAddress& peer, unsigned int frameId,
+                      const std::vector<unsigned short>& fragments );
+
+    /**
+     * @brief Minimum time between two forced keyframes, in ms
+     */
+    static const unsigned int keyframeInterval = 300;
+
+    /**
+     * @brief Size of the VP8 video
+     */
+    static const unsigned int videoWidth = 640;
+    static const unsigned int videoHeight = 480;
+    /**
+     * @brief Target bitrate of the VP8 video, in kbit/s
+     */
+    static const unsigned int videoBitrate = 400;
+    /**
+     * @brief Share of the video bitrate which may be retransmitted, in %
+     */
+    static const unsigned int maxRetransmitRate = 25;
+    /**
+     * @brief Size of the IPv4 and UDP headers of a datagram
+     */
+    static const unsigned int datagramOverhead = 28;
+    /**
+     * @brief Pacing rate, in % of the video bitrate sent to all the users
+     *
+     * Frames are still sent within the frame interval when they are larger
+     * than the bitrate allows, as keyframes are.
+     */
+    static const unsigned int pacingRate = 150;
+
 private:
+  void runJpeg();
+  void runVp8();
+  void sendFrame ( std::vector<FragmentPacket>& list );
+  unsigned int fragmentSize() const;
+  unsigned int repairCount ( unsigned int frameSize,
+                             unsigned int fragmentSize ) const;
+
   VideoConferenceP2P* conference;
+  std::string source;
+  std::atomic<bool> keyframeRequested;
+  std::atomic<bool> stopped;
+  std::atomic<unsigned long> byteCount;
+  std::atomic<unsigned long> frameCount;
+  std::atomic<unsigned long> serializationTime;
+  std::atomic<unsigned long> oversized;
+  FrameClock frameClock;
+  // Upper bound of the fragment header size by wire format
+  size_t headerSize[2];
+
+  Pacer pacer;
+  FragmentCache cache;
+  // Retransmission budget in bytes, receiver thread only
+  double retransmitTokens;
+  boost::posix_time::ptime lastRefill;
+  unsigned long nackCount;
+  unsigned long retransmitted;
+  unsigned long retransmitLimited;
+  unsigned long retransmitExpired;
 };
 
 #endif // SENDER_H
@@ -19,9 +19,21 @@
 #include "net/udpsocket.h"
 #include "videoconferencep2p.h"
 #include "core/log.h"
+#include "decodepool.h"
+#include "gui.h"
+#include "packets/keyframerequestpacket.h"
+#include "packets/nackpacket.h"
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <algorithm>
+
+const unsigned int statsInterval = 24 * 10;
+
+const unsigned int User::nackInterval;
 
 User::User ( string s, SockAddress sa, VideoConferenceP2P& vc )
-    : video_conference ( vc )
+    : delay ( 0 ), wireFormat ( wireGtt ), video_conference ( vc ),
+      dropped ( 0 ), late ( 0 ), decodeScheduled ( false ),
+      receivingVp8 ( false ), lost ( 0 ), nacked ( 0 )
 {
     name = s;
     address = sa;
@@ -54,6 +66,24 @@ void User::updateDelay ( short unsigned int delay )
     this->delay = delay;
 }
 
+/**
+ * @brief Get the encoding this user accepts for fragments
+ *
+ * Every user starts with the GTT text format until its RTT requests
+ * advertise support for the binary one.
+ */
+WireFormat User::getWireFormat() const
+{
+    QMutexLocker lock ( &mutex_wire );
+    return wireFormat;
+}
+
+void User::setWireFormat ( WireFormat format )
+{
+    QMutexLocker lock ( &mutex_wire );
+    wireFormat = format;
+}
+
 /**
  * @brief Send data through the socket
  *
@@ -69,39 +99,257 @@ void User:: send ( const void* data, int size )
 void User::receive ( FragmentPacket& fp )
 {
     fragmentManager.eat ( fp );
-    if ( fragmentManager.hasCompleteFrame() ) {
+
+    // A lost VP8 frame breaks the references of the next ones, whether it
+    // was abandoned incomplete or none of its fragments arrived. Frames are
+    // only counted once the reassembly window gave up on them, so that
+    // reordered frames do not cost a keyframe.
+    const FragmentStats reassembly = fragmentManager.getStats();
+    if ( reassembly.abandoned + reassembly.missing != lost && receivingVp8 )
+        requestKeyframe();
+    lost = reassembly.abandoned + reassembly.missing;
+    requestMissing();
+
+    while ( fragmentManager.hasCompleteFrame() ) {
         //Epyx::log::info << "New Frame for " << name << Epyx::log::endl;
-        add ( fragmentManager.getCompleteFrame() );
+        // Frames wait compressed until one is selected for display
+        Frame frame;
+        fragmentManager.getCompleteFrame ( frame );
+        receivingVp8 = !frame.isJpeg();
+        add ( frame );
+
+        const FragmentStats stats = fragmentManager.getStats();
+        if ( stats.completed % statsInterval == 0 ) {
+            const JitterStats jitter = jitterBuffer.getStats();
+            Epyx::log::debug << "Frames from " << name << ": "
+                             << stats.completed << " completed, "
+                             << stats.late << " late, "
+                             << stats.abandoned << " abandoned, "
+                             << stats.missing << " missing, "
+                             << stats.recovered << " recovered, "
+                             << dropped << " dropped, "
+                             << late << " older than a queued frame, "
+                             << nacked << " fragments NACKed, "
+                             << jitter.late << " late for playout, "
+                             << "jitter " << jitter.jitter << " us, "
+                             << "playout delay " << jitter.delay << " ms"
+                             << Epyx::log::endl;
+        }
     }
 }
 
-void User::add ( Frame* f )
+/**
+ * @brief Ask the peer again for the fragments it seems to have lost
+ *
+ * Only frames which a retransmission can reach before their playout time
+ * are asked, the others are left to the parity fragments or abandoned.
+ */
+void User::requestMissing()
 {
-    QMutexLocker lock ( &mutex_frames );
-    f->setDelay ( delay );
-    frames.push ( f );
+    const ptime now = boost::posix_time::microsec_clock::local_time();
+    const unsigned int rtt = 2 * getDelay();
+    std::vector<FragmentNack> nacks;
+    fragmentManager.getNacks ( now, std::max ( rtt, nackInterval ), nacks );
+
+    for ( auto it = nacks.begin(); it != nacks.end(); it++ ) {
+        ptime deadline;
+        if ( jitterBuffer.deadline ( it->packetTimestamp, deadline ) &&
+                now + boost::posix_time::milliseconds ( rtt ) >= deadline )
+            continue;
+
+        NackPacket nack ( video_conference.host, address, it->frameId,
+                          it->fragments );
+        const byte_str data = nack.build();
+        send ( data.data(), data.size() );
+        nacked += nack.fragments.size();
+    }
+}
+
+FragmentStats User::getFragmentStats() const
+{
+    return fragmentManager.getStats();
 }
 
-QImage User::getLatestFrame ( User::ptime maxTime )
+/**
+ * @brief Decode the frames selected for display
+ *
+ * Called by a decoder worker. No other worker handles this user until the
+ * pending queue is empty, so frames are decoded in order. VP8 frames which
+ * are followed by a newer one are decoded as references but not converted
+ * to an image.
+ */
+void User::decodePending ( DecodePool& pool )
 {
-    QMutexLocker lock ( &mutex_frames );
-    QImage image;
+    while ( true ) {
+        Frame frame;
+        QSize size;
+        unsigned int depth;
+        bool newest;
+        {
+            QMutexLocker lock ( &mutex_decode );
+            if ( pendingDecode.empty() ) {
+                decodeScheduled = false;
+                return;
+            }
+            size = displaySize;
+            depth = pendingDecode.size();
+            frame = std::move ( pendingDecode.front() );
+            pendingDecode.pop_front();
+            newest = pendingDecode.empty();
+        }
+
+        ptime start = boost::posix_time::microsec_clock::local_time();
+        if ( frame.isJpeg() ) {
+            frame.decode ( size );
+        } else if ( !vpxDecoder && !frame.isKeyframe() ) {
+            // Joined a running video, nothing can be decoded before a keyframe
+            requestKeyframe();
+        } else {
+            if ( !vpxDecoder )
+                vpxDecoder.reset ( new webm::VpxDecoder() );
+            if ( !frame.decode ( *vpxDecoder, size, newest ) )
+                requestKeyframe();
+        }
+        pool.recordDecode ( ( boost::posix_time::microsec_clock::local_time() -
+                              start ).total_microseconds(), depth );
 
-    if ( frames.empty() == true ) {
-        return image;
+        const QImage image = frame.getImage();
+        discard ( frame );
+        if ( image.isNull() )
+            continue;
+        {
+            QMutexLocker lock ( &mutex_decode );
+            decodedImage = image;
+        }
+        video_conference.getGUI()->notifyDecoded ( this );
     }
+}
+
+/**
+ * @brief Give the buffer of a frame back to the pool
+ */
+void User::discard ( Frame& frame )
+{
+    byte_str data;
+    frame.takeData ( data );
+    fragmentManager.getPool().release ( data );
+}
 
-    while ( ! ( frames.empty() ) && frames.top()->getTime() <= maxTime ) {
-        // std::cout << "Sending new frame" << std::endl;
-        // std::cout << "Taille pile : " << frames.size() << std::endl;
-        Frame* frame = frames.top();
-        image = frame->getImage();
-        frames.pop();
-        delete frame;
+/**
+ * @brief Queue a completed frame for display
+ *
+ * Called by the receiver thread only. The frame is dropped if the display
+ * lags too far behind, or if a newer frame is already queued.
+ */
+void User::add ( Frame& f )
+{
+    f.setTime ( jitterBuffer.playoutTime ( f.getTime(), f.getRealTime() ) );
+    const FrameRing::PushResult result = frames.push ( f );
+    if ( result != FrameRing::pushed ) {
+        if ( !f.isJpeg() )
+            requestKeyframe();
+        discard ( f );
+        if ( result == FrameRing::late )
+            late++;
+        else
+            dropped++;
+        return;
+    }
+    video_conference.getGUI()->notifyFrame();
+}
+
+/**
+ * @brief Get the playout time of the next frame, from the GUI thread
+ * @return false if there is no frame to play
+ */
+bool User::getNextPlayoutTime ( User::ptime& time )
+{
+    Frame* frame = frames.front();
+    if ( frame == NULL )
+        return false;
+    time = frame->getTime();
+    return true;
+}
+
+/**
+ * @brief Select the frames to decode, from the GUI thread
+ *
+ * Among the JPEG frames which are due, only the newest one is decoded, by
+ * the decode pool, which notifies the GUI once its image is ready. VP8
+ * frames are all decoded since the next ones refer to them.
+ */
+void User::playout ( User::ptime now )
+{
+    unsigned int skipped = 0;
+    bool post = false;
+    {
+        QMutexLocker lock ( &mutex_decode );
+        Frame* frame;
+        while ( ( frame = frames.front() ) != NULL &&
+                frame->getTime() <= now ) {
+            if ( !pendingDecode.empty() && pendingDecode.back().isJpeg() ) {
+                discard ( pendingDecode.back() );
+                pendingDecode.pop_back();
+                skipped++;
+            }
+            pendingDecode.push_back ( std::move ( *frame ) );
+            frames.pop();
+            if ( !decodeScheduled ) {
+                decodeScheduled = true;
+                post = true;
+            }
+        }
     }
 
+    DecodePool* pool = video_conference.getDecodePool();
+    if ( skipped > 0 )
+        pool->recordSkipped ( skipped );
+    if ( post )
+        pool->post ( new DecodeJob ( this ) );
+}
+
+/**
+ * @brief Get the image decoded since the previous call
+ * @return the image, or a null image
+ */
+QImage User::takeDecodedImage()
+{
+    QMutexLocker lock ( &mutex_decode );
+    QImage image = decodedImage;
+    decodedImage = QImage();
     return image;
 }
 
+/**
+ * @brief Set the size of the tile this user is displayed in
+ *
+ * Frames are decoded directly at this size when they are larger.
+ */
+void User::setDisplaySize ( const QSize& size )
+{
+    QMutexLocker lock ( &mutex_decode );
+    displaySize = size;
+}
 
+/**
+ * @brief Ask this user for a VP8 keyframe, from any thread
+ *
+ * Requests are spaced by keyframeRequestInterval, the sender forcing a
+ * single keyframe for a burst of them anyway.
+ */
+void User::requestKeyframe()
+{
+    {
+        QMutexLocker lock ( &mutex_keyframe );
+        const ptime now = boost::posix_time::microsec_clock::local_time();
+        if ( !lastKeyframeRequest.is_not_a_date_time() &&
+                ( now - lastKeyframeRequest ).total_milliseconds() <
+                keyframeRequestInterval )
+            return;
+        lastKeyframeRequest = now;
+    }
 
+    KeyframeRequestPacket request ( video_conference.host, address );
+    const byte_str packet = request.build();
+    send ( packet.data(), packet.length() );
+}
@@ -22,10 +22,15 @@
 #include "net/sockaddress.h"
 #include "net/udpsocket.h"
 #include "boost/shared_ptr.hpp"
-#include <queue>
+#include <deque>
+#include <atomic>
+#include <memory>
 #include "frame.h"
 #include "webm/framepacket.h"
+#include "webm/vpxdecoder.h"
 #include "fragmentmanager.h"
+#include "framering.h"
+#include "jitterbuffer.h"
 #include <QLabel>
 #include <boost/date_time/posix_time/ptime.hpp>
 #include <QMutex>
@@ -34,6 +39,7 @@ using namespace std;
 using namespace Epyx;
 
 class VideoConferenceP2P;
+class DecodePool;
 
 using namespace Epyx::webm;
 
@@ -46,20 +52,59 @@ public:
     string getIpStr();
     unsigned short int getDelay() const;
     void updateDelay ( unsigned short int delay );
+    WireFormat getWireFormat() const;
+    void setWireFormat ( WireFormat format );
     void send(const void *data, int size);
     void receive ( FragmentPacket& fp);
-    void add ( Frame* f);
-    QImage getLatestFrame(ptime maxTime);
+    void add ( Frame& f );
+    void decodePending ( DecodePool& pool );
+    bool getNextPlayoutTime ( ptime& time );
+    void playout ( ptime now );
+    QImage takeDecodedImage();
+    void setDisplaySize ( const QSize& size );
+    void requestKeyframe();
+
+    /**
+     * @brief Minimum time between two keyframe requests, in ms
+     */
+    static const unsigned int keyframeRequestInterval = 500;
+    /**
+     * @brief Minimum time between two NACKs of a frame, in ms
+     *
+     * The round trip time is used instead when it is longer.
+     */
+    static const unsigned int nackInterval = 20;
+    FragmentStats getFragmentStats() const;
 
 private:
+    void discard ( Frame& frame );
+    void requestMissing();
+
     string name;
     SockAddress address;
     unsigned short int delay;
+    WireFormat wireFormat;
     VideoConferenceP2P& video_conference;
-    priority_queue<Frame*, std::vector<Frame*>, FrameCompare> frames;
+    FrameRing frames;
+    JitterBuffer jitterBuffer;
+    std::atomic<unsigned long> dropped;
+    std::atomic<unsigned long> late;
     FragmentManager fragmentManager;
+    deque<Frame> pendingDecode;
+    QImage decodedImage;
+    QSize displaySize;
+    // Only used by the worker decoding this user
+    std::unique_ptr<webm::VpxDecoder> vpxDecoder;
+    // Whether the stream is VP8 and misses a frame, receiver thread only
+    bool receivingVp8;
+    unsigned long lost;
+    unsigned long nacked;
+    ptime lastKeyframeRequest;
+    mutable QMutex mutex_keyframe;
+    bool decodeScheduled;
     mutable QMutex mutex_delay;
-    mutable QMutex mutex_frames;
+    mutable QMutex mutex_wire;
+    mutable QMutex mutex_decode;
 };
 
 #endif // USER_H
@@ -22,6 +22,9 @@
 #include "user.h"
 #include "gui.h"
 #include "sender.h"
+#include "decodepool.h"
+#include "congestioncontroller.h"
+#include <thread>
 
 typedef std::pair<SockAddress, User*> userEntry;
 
@@ -30,6 +33,12 @@ VideoConferenceP2P::VideoConferenceP2P ( SockAddress sa ) : host ( sa ),
 {
     gui = new GUI ( this );
 
+    // Leave a core to the receiver and GUI threads
+    decodePool = new DecodePool (
+        std::max<int> ( 1, std::thread::hardware_concurrency() - 1 ) );
+
+    congestionController = new CongestionController ( Sender::videoBitrate );
+
     rttManager = new RTTManager ( this );
     rttManager->setThreadName (
         "RTTManager " +
@@ -73,6 +82,16 @@ User* VideoConferenceP2P::getUser ( SockAddress address )
     return it->second;
 }
 
+/**
+ * @brief Get the user at the given address, or NULL if there is none
+ */
+User* VideoConferenceP2P::findUser ( SockAddress address )
+{
+    QMutexLocker lock ( &mutex_user );
+    auto it = users.find ( address );
+    return it != users.end() ? it->second : NULL;
+}
+
 const map< SockAddress, User*>& VideoConferenceP2P::getUsers()
 {
     return users;
@@ -99,6 +118,55 @@ RTTManager* VideoConferenceP2P::getRTTManager()
     return rttManager;
 }
 
+CongestionController* VideoConferenceP2P::getCongestionController()
+{
+    return congestionController;
+}
+
+GUI* VideoConferenceP2P::getGUI()
+{
+    return gui;
+}
+
+DecodePool* VideoConferenceP2P::getDecodePool()
+{
+    return decodePool;
+}
+
+/**
+ * @brief Set the number of threads decoding received frames
+ */
+void VideoConferenceP2P::setDecodeWorkers ( int n )
+{
+    decodePool->setNumWorkers ( n );
+}
+
+/**
+ * @brief Set what the sender sends, see Sender::setSource()
+ */
+void VideoConferenceP2P::setVideoSource ( const string& source )
+{
+    sender->setSource ( source );
+}
+
+/**
+ * @brief Make the next sent VP8 frame a keyframe, for a receiver which lost
+ *        the video
+ */
+void VideoConferenceP2P::requestKeyframe()
+{
+    sender->requestKeyframe();
+}
+
+/**
+ * @brief Send again the fragments of a recent frame a receiver lost
+ */
+void VideoConferenceP2P::retransmit ( SockAddress peer, unsigned int frameId,
+                                      const vector<unsigned short>& fragments )
+{
+    sender->retransmit ( peer, frameId, fragments );
+}
+
 void VideoConferenceP2P::start()
 {
 
@@ -111,6 +179,59 @@ void VideoConferenceP2P::start()
     sender->start();
 }
 
+/**
+ * @brief Stop sending and wait until the sender released its encoder
+ */
+void VideoConferenceP2P::stop()
+{
+    sender->stop();
+    sender->wait();
+}
+
+/**
+ * @brief Enable the binary wire format for fragments
+ *
+ * When disabled, this host neither advertises nor sends binary fragments and
+ * every peer gets the GTT text format, which is easier to debug.
+ */
+void VideoConferenceP2P::setBinaryWire ( bool b )
+{
+    binary_wire = b;
+}
+
+bool VideoConferenceP2P::useBinaryWire() const
+{
+    return binary_wire;
+}
+
+/**
+ * @brief Set the MTU of the paths to the peers, fragments are sized so that
+ * every datagram fits in it
+ *
+ * It is bounded by minMtu and by the datagrams the receivers accept.
+ */
+void VideoConferenceP2P::setMtu ( unsigned int mtu )
+{
+    if ( mtu < minMtu )
+        mtu = minMtu;
+    if ( mtu > Receiver::datagramSize )
+        mtu = Receiver::datagramSize;
+    this->mtu = mtu;
+}
+
+unsigned int VideoConferenceP2P::getMtu() const
+{
+    return mtu;
+}
+
+/**
+ * @brief Set how many bytes of video may be sent back-to-back
+ */
+void VideoConferenceP2P::setPacingBurst ( unsigned int burst )
+{
+    sender->setPacingBurst ( burst );
+}
+
 void VideoConferenceP2P::display ( bool d )
 {
     display_vc = d;
@@ -19,6 +19,7 @@
 #define VIDEOCONFERENCEP2P_H
 
 #include <map>
+#include <vector>
 #include "net/sockaddress.h"
 #include "net/udpserver.h"
 #include "user.h"
@@ -29,6 +30,8 @@
 class RTTManager;
 class GUI;
 class Sender;
+class DecodePool;
+class CongestionController;
 
 using namespace std;
 using namespace Epyx;
@@ -40,13 +43,33 @@ public:
     const SockAddress host;
     VideoConferenceP2P ( SockAddress sa );
     User* getUser ( SockAddress address );
+    User* findUser ( SockAddress address );
     void updateDelay ( SockAddress address, short unsigned int delay );
     const map< SockAddress, User* >& getUsers();
     UDPServer& getServer();
     RTTManager* getRTTManager();
+    DecodePool* getDecodePool();
+    GUI* getGUI();
+    CongestionController* getCongestionController();
+    void setDecodeWorkers ( int n );
+    void setVideoSource ( const string& source );
+    void requestKeyframe();
+    void retransmit ( SockAddress peer, unsigned int frameId,
+                      const vector<unsigned short>& fragments );
     void printUsers();
     void start();
+    void stop();
     void display( bool d);
+    void setBinaryWire ( bool b );
+    bool useBinaryWire() const;
+    void setMtu ( unsigned int mtu );
+    void setPacingBurst ( unsigned int burst );
+    unsigned int getMtu() const;
+
+    /**
+     * @brief Smallest MTU every IPv4 path must carry
+     */
+    static const unsigned int minMtu = 576;
 
 protected:
     char* debug;
@@ -56,11 +79,15 @@ private:
     //void initialisation();
     map<SockAddress, User*> users;
     RTTManager* rttManager;
+    DecodePool* decodePool;
+    CongestionController* congestionController;
     Receiver receiver;
     GUI* gui;
     Sender* sender;
     QMutex mutex_user;
     bool display_vc = true;
+    bool binary_wire = true;
+    unsigned int mtu = 1500;
 };
 
 #endif // VIDEOCONFERENCEP2P_H